@@ -0,0 +1,44 @@
+#version 430
+
+layout(local_size_x = 64) in;
+
+struct Meshlet {
+  vec4 sphere;   // center, radius
+  vec4 cone;     // axis, cutoff
+  uvec4 range;   // index offset, triangle count
+};
+
+layout(std430, binding = 0) readonly buffer Meshlets { Meshlet meshlets[]; };
+layout(std430, binding = 1) readonly buffer SourceIndices { uint source_indices[]; };
+layout(std430, binding = 2) writeonly buffer OutputIndices { uint output_indices[]; };
+layout(std430, binding = 3) buffer DrawCommand {
+  uint count;
+  uint instance_count;
+  uint first_index;
+  uint base_vertex;
+  uint base_instance;
+};
+
+uniform vec4 planes[6];   // model space, normalized
+uniform vec3 camera;      // model space
+uniform uint meshlet_count;
+
+void main () {
+  uint id = gl_GlobalInvocationID.x;
+  if ( id >= meshlet_count ) return;
+  Meshlet meshlet = meshlets[id];
+  vec3 center = meshlet.sphere.xyz;
+  float radius = meshlet.sphere.w;
+
+  for ( int i = 0 ; i < 6 ; ++i ) {
+    if ( dot(planes[i].xyz, center) + planes[i].w < -radius ) return;
+  }
+  vec3 to_center = center - camera;
+  if ( dot(to_center, meshlet.cone.xyz) >= meshlet.cone.w * length(to_center) + radius ) return;
+
+  uint n_indices = 3u * meshlet.range.y;
+  uint offset = atomicAdd(count, n_indices);
+  for ( uint i = 0u ; i < n_indices ; ++i ) {
+    output_indices[offset + i] = source_indices[meshlet.range.x + i];
+  }
+}
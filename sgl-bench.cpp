@@ -0,0 +1,107 @@
+/// sgl-bench.cpp
+/// Microbenchmarks for the sgl-simd kernels against scalar glm loops, correctness is checked by sgl-simd-test
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "sgl-simd.h"
+
+const size_t n_vertices = 1 << 20;
+const int repetitions = 20;
+
+
+//! Best of repetitions, setup is not timed.
+float time_ms(std::function<void()> setup, std::function<void()> kernel)
+{
+  float best = 1e30f;
+  for (int i = 0; i < repetitions; ++i) {
+    setup();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    kernel();
+    auto current_time = std::chrono::high_resolution_clock::now();
+    best = std::min(best, std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(current_time - start_time).count());
+  }
+  return best;
+}
+
+
+void print(const std::string& kernel, const std::string& level, float time, float reference_time)
+{
+  std::cout << std::setw(12) << kernel << std::setw(10) << level << std::setw(10) << std::fixed << std::setprecision(3) << time << " ms"
+	    << std::setw(8) << std::setprecision(2) << reference_time / time << "x" << std::endl;
+}
+
+
+int main( void )
+{
+  // odd size so the scalar tails get exercised
+  const size_t n = n_vertices + 13;
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+  std::vector<glm::vec3> positions(n), normals(n);
+  std::vector<glm::vec2> uvs(n);
+  for (size_t i = 0; i < n; ++i) {
+    positions[i] = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+    normals[i] = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+    uvs[i] = glm::vec2(distribution(generator), distribution(generator));
+  }
+  normals[0] = glm::vec3(0.0f);
+
+  glm::mat4 matrix = glm::translate( glm::mat4(1.0f), glm::vec3(1.0f, -2.0f, 3.0f) )
+    * glm::rotate( glm::mat4(1.0f), 0.7f, glm::vec3(0.3f, 1.0f, 0.2f) ) * glm::scale( glm::mat4(1.0f), glm::vec3(1.5f, 0.5f, 2.0f) );
+  const glm::vec2 uv_scale(1.0f, -1.0f), uv_offset(0.0f, 0.0f);
+
+  // scalar glm timings
+  std::vector<glm::vec3> work3;
+  std::vector<glm::vec2> work2;
+  sglAABB reference_box;
+  float glm_transform = time_ms( [&]{ work3 = positions; }, [&]{
+      for (auto& point: work3) point = glm::vec3( matrix * glm::vec4(point, 1.0f) );
+    } );
+  float glm_aabb = time_ms( []{}, [&]{ reference_box = compute_aabb(positions); } );
+  float glm_normalize = time_ms( [&]{ work3 = normals; }, [&]{
+      for (auto& normal: work3) {
+	float length = glm::length(normal);
+	normal = length > 0 ? normal / length : normal;
+      }
+    } );
+  float glm_uvs = time_ms( [&]{ work2 = uvs; }, [&]{
+      for (auto& uv: work2) uv = uv * uv_scale + uv_offset;
+    } );
+
+  std::cout << "vertices: " << n << ", best of " << repetitions << ", speedup relative to glm AoS loop\n";
+  print("transform", "glm", glm_transform, glm_transform);
+  print("aabb", "glm", glm_aabb, glm_aabb);
+  print("normalize", "glm", glm_normalize, glm_normalize);
+  print("uv", "glm", glm_uvs, glm_uvs);
+
+  sglSoA3 soa_positions = to_soa(positions), soa_normals = to_soa(normals), work_soa3;
+  sglSoA2 soa_uvs = to_soa(uvs), work_soa2;
+  for (int level = 0; level <= static_cast<int>( simd_supported() ); ++level) {
+    set_simd_level( static_cast<sglSimdLevel>(level) );
+    std::string name = simd_level_name( simd_level() );
+
+    float time = time_ms( [&]{ work_soa3 = soa_positions; }, [&]{ transform_points(matrix, work_soa3); } );
+    print("transform", name, time, glm_transform);
+    sglAABB box;
+    time = time_ms( []{}, [&]{ box = compute_aabb(soa_positions); } );
+    print("aabb", name, time, glm_aabb);
+    time = time_ms( [&]{ work_soa3 = soa_normals; }, [&]{ normalize_vectors(work_soa3); } );
+    print("normalize", name, time, glm_normalize);
+    time = time_ms( [&]{ work_soa2 = soa_uvs; }, [&]{ transform_uvs(work_soa2, uv_scale, uv_offset); } );
+    print("uv", name, time, glm_uvs);
+  }
+
+  return 0;
+}
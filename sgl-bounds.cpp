@@ -0,0 +1,27 @@
+/// sgl-bounds.cpp
+/// Bounding volumes shared by the culling and vertex kernel modules
+/// author: Ulrike Hager
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sgl-bounds.h"
+
+
+sglAABB compute_aabb(const std::vector<glm::vec3>& vertices)
+{
+  sglAABB box;
+  if (vertices.empty()) {
+    box.min = glm::vec3(0.0f);
+    box.max = glm::vec3(0.0f);
+    return box;
+  }
+  box.min = vertices.at(0);
+  box.max = vertices.at(0);
+  for (const auto& vertex: vertices) {
+    box.min = glm::min(box.min, vertex);
+    box.max = glm::max(box.max, vertex);
+  }
+  return box;
+}
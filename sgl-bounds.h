@@ -0,0 +1,24 @@
+/// sgl-bounds.h
+/// Bounding volumes shared by the culling and vertex kernel modules
+/// author: Ulrike Hager
+
+#ifndef SGL_BOUNDS
+#define SGL_BOUNDS
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+struct sglAABB
+{
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+
+//! Axis aligned bounding box of a vertex list, e.g. output of load_blender_obj. Empty input gives a zero box.
+sglAABB compute_aabb(const std::vector<glm::vec3>& vertices);
+
+
+#endif //  SGL_BOUNDS
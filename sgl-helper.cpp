@@ -8,6 +8,8 @@
 #include <vector>
 #include <sstream>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 #include <GL/glew.h>
 
@@ -290,6 +292,172 @@ void load_blender_obj(const std::string& file, std::vector<glm::vec3>& vertices,
 }
 
 
+namespace {
+
+  //! obj indices are 1-based, negative values count back from the last entry read so far
+  uint32_t obj_index(long index, size_t count)
+  {
+    long result = index > 0 ? index - 1 : (long)count + index;
+    if ( index == 0 || result < 0 || result >= (long)count )
+      throw std::runtime_error("[load_blender_obj_stream] Face index out of range");
+    return (uint32_t)result;
+  }
+
+
+  //! Parses one "v/vt/vn" face corner, advances pos
+  void read_corner(const char*& pos, long corner[3])
+  {
+    for ( uint32_t i = 0 ; i < 3 ; ++i ) {
+      char* end = nullptr;
+      corner[i] = std::strtol(pos, &end, 10);
+      if ( end == pos || ( i < 2 && *end != '/' ) )
+	throw std::runtime_error("File can't be read by parser. Try exporting with other options");
+      pos = ( i < 2 ) ? end + 1 : end;
+    }
+  }
+
+
+  struct ObjStreamState
+  {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    sglMeshBatch batch;
+    uint32_t batch_triangles;
+    std::function<void(const sglMeshBatch&)> callback;
+
+    void add_corner(const long corner[3])
+    {
+      batch.vertices.push_back( vertices[ obj_index(corner[0], vertices.size()) ] );
+      batch.uvs.push_back( uvs[ obj_index(corner[1], uvs.size()) ] );
+      batch.normals.push_back( normals[ obj_index(corner[2], normals.size()) ] );
+    }
+
+    void flush()
+    {
+      if ( batch.vertices.empty() ) return;
+      callback(batch);
+      batch.vertices.clear();
+      batch.uvs.clear();
+      batch.normals.clear();
+    }
+
+    //! line is null terminated
+    void parse_line(const char* line)
+    {
+      while ( *line == ' ' || *line == '\t' ) ++line;
+      char* end = nullptr;
+      if ( line[0] == 'v' && line[1] == ' ' ) {
+	glm::vec3 vertex;
+	vertex.x = std::strtof(line + 2, &end);
+	vertex.y = std::strtof(end, &end);
+	vertex.z = std::strtof(end, &end);
+	vertices.push_back(vertex);
+      }
+      else if ( line[0] == 'v' && line[1] == 't' ) {
+	glm::vec2 uv;
+	uv.x = std::strtof(line + 2, &end);
+	uv.y = std::strtof(end, &end);
+	uv.y *= -1;
+	uvs.push_back(uv);
+      }
+      else if ( line[0] == 'v' && line[1] == 'n' ) {
+	glm::vec3 normal;
+	normal.x = std::strtof(line + 2, &end);
+	normal.y = std::strtof(end, &end);
+	normal.z = std::strtof(end, &end);
+	normals.push_back(normal);
+      }
+      else if ( line[0] == 'f' && line[1] == ' ' ) {
+	const char* pos = line + 2;
+	long first[3], previous[3], current[3];
+	uint32_t n_corners = 0;
+	while ( true ) {
+	  while ( *pos == ' ' || *pos == '\t' || *pos == '\r' ) ++pos;
+	  if ( *pos == '\0' ) break;
+	  read_corner(pos, current);
+	  if ( n_corners == 0 ) {
+	    std::copy(current, current + 3, first);
+	  }
+	  else if ( n_corners >= 2 ) {
+	    add_corner(first);
+	    add_corner(previous);
+	    add_corner(current);
+	  }
+	  std::copy(current, current + 3, previous);
+	  ++n_corners;
+	}
+	if ( n_corners < 3 )
+	  throw std::runtime_error("File can't be read by parser. Try exporting with other options");
+	if ( batch.vertices.size() >= 3 * (size_t)batch_triangles )
+	  flush();
+      }
+    }
+  };
+
+} // namespace
+
+
+void load_blender_obj_stream(const std::string& file, uint32_t batch_triangles, std::function<void(const sglMeshBatch&)> callback, size_t block_size)
+{
+  if ( batch_triangles == 0 || block_size == 0 )
+    throw std::runtime_error("[load_blender_obj_stream] batch_triangles and block_size must be > 0");
+
+  ObjStreamState state;
+  state.batch_triangles = batch_triangles;
+  state.callback = callback;
+  // a fan can overshoot the batch size by a few triangles before it is flushed
+  state.batch.vertices.reserve(3 * (size_t)batch_triangles + 6);
+  state.batch.uvs.reserve(3 * (size_t)batch_triangles + 6);
+  state.batch.normals.reserve(3 * (size_t)batch_triangles + 6);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  FILE * input = fopen(file.c_str(), "r");
+  if ( !input ) 
+    throw std::runtime_error("[load_blender_obj_stream] Couldn't open file " + file );
+
+  std::vector<char> block(block_size + 1);
+  size_t filled = 0;
+  try {
+    while ( true ) {
+      size_t n_read = fread(&block[filled], 1, block_size - filled, input);
+      filled += n_read;
+      bool done = ( n_read == 0 );
+      size_t line_start = 0;
+      for ( size_t i = 0 ; i < filled ; ++i ) {
+	if ( block[i] != '\n' ) continue;
+	block[i] = '\0';
+	state.parse_line(&block[line_start]);
+	line_start = i + 1;
+      }
+      if ( done ) {
+	// last line without newline
+	if ( line_start < filled ) {
+	  block[filled] = '\0';
+	  state.parse_line(&block[line_start]);
+	}
+	break;
+      }
+      if ( line_start == 0 && filled == block_size )
+	throw std::runtime_error("[load_blender_obj_stream] Line longer than block size in " + file );
+      std::memmove(&block[0], &block[line_start], filled - line_start);
+      filled -= line_start;
+    }
+  }
+  catch (...) {
+    fclose(input);
+    throw;
+  }
+  fclose(input);
+  state.flush();
+
+  auto current_time = std::chrono::high_resolution_clock::now();  
+  float time = std::chrono::duration_cast<std::chrono::duration<float>>(current_time - start_time).count() ;
+  std::cout << "time to stream obj file: " << time << "\n";
+}
+
+
 ////////////////////
 ////    SDL2    ////
 ////////////////////
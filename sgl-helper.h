@@ -5,6 +5,8 @@
 #ifndef SGL_HELPER
 #define SGL_HELPER
 
+#include <functional>
+#include <string>
 #include <vector>
 
 #include <GL/glew.h>
@@ -33,6 +35,20 @@ void load_blender_obj(const std::string& file, std::vector<glm::vec3>& vertices,
 void load_blender_obj_fscan(const std::string& file, std::vector<glm::vec3>& vertices, std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals);
 void load_blender_obj_ifstream(const std::string& file, std::vector<glm::vec3>& vertices, std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals);
 
+//! Expanded triangles as delivered by load_blender_obj_stream, same layout as the load_blender_obj output.
+struct sglMeshBatch
+{
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec3> normals;
+};
+
+//! Reads the file in blocks of block_size bytes and calls callback every time batch_triangles triangles are complete, and once for the rest.
+//! The batch is reused after the callback returns, copy what you want to keep (e.g. glBufferSubData).
+//! Only the v/vt/vn tables are kept for the whole file since faces can reference any earlier entry; no index arrays and no fully expanded mesh.
+//! Faces with more than 3 corners are triangulated as fans. Throws if a line is longer than block_size.
+void load_blender_obj_stream(const std::string& file, uint32_t batch_triangles, std::function<void(const sglMeshBatch&)> callback, size_t block_size = 65536);
+
 ////////////////////
 ////    SDL2    ////
 ////////////////////
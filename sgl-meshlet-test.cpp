@@ -0,0 +1,171 @@
+/// sgl-meshlet-test.cpp
+/// Checks build_meshlets and cull_meshlets without a window or GL context, exits non-zero on failure
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "sgl-meshlet.h"
+
+int failures = 0;
+
+
+void check(bool condition, const std::string& what)
+{
+  std::cout << (condition ? "pass: " : "FAIL: ") << what << std::endl;
+  if (!condition) ++failures;
+}
+
+
+//! Unit sphere as triangle soup like load_blender_obj returns it, counter clockwise seen from outside.
+//! The triangles touching the poles are degenerate.
+void make_sphere(uint32_t rings, uint32_t segments, std::vector<glm::vec3>& vertices, std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals)
+{
+  const float pi = 3.14159265f;
+  auto point = [&](uint32_t ring, uint32_t segment) {
+    float theta = pi * ring / rings, phi = 2 * pi * segment / segments;
+    return glm::vec3( std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) );
+  };
+  auto add = [&](uint32_t ring, uint32_t segment) {
+    glm::vec3 position = point(ring, segment);
+    vertices.push_back(position);
+    uvs.push_back( glm::vec2( float(segment) / segments, float(ring) / rings ) );
+    normals.push_back(position);
+  };
+  for (uint32_t ring = 0; ring < rings; ++ring) {
+    for (uint32_t segment = 0; segment < segments; ++segment) {
+      uint32_t next = segment + 1;
+      // theta runs down and phi around, so (ring, segment) -> (ring, next) -> (ring+1, next) faces outwards
+      add(ring, segment); add(ring, next); add(ring+1, next);
+      add(ring, segment); add(ring+1, next); add(ring+1, segment);
+    }
+  }
+}
+
+
+bool same_mesh(const sglMeshletMesh& a, const sglMeshletMesh& b)
+{
+  if ( a.vertices != b.vertices || a.uvs != b.uvs || a.normals != b.normals || a.indices != b.indices || a.meshlets.size() != b.meshlets.size() )
+    return false;
+  for (size_t i = 0; i < a.meshlets.size(); ++i) {
+    const sglMeshlet& x = a.meshlets[i];
+    const sglMeshlet& y = b.meshlets[i];
+    if ( x.index_offset != y.index_offset || x.triangle_count != y.triangle_count || x.vertex_count != y.vertex_count
+	 || x.center != y.center || x.radius != y.radius || x.cone_axis != y.cone_axis || x.cone_cutoff != y.cone_cutoff )
+      return false;
+  }
+  return true;
+}
+
+
+//! Triangles that have to be drawn: not degenerate, facing the camera and with at least one corner inside the view volume.
+//! Returns how many were required and how many of those are missing from indices[0, count).
+uint32_t missing_triangles(const sglMeshletMesh& mesh, const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position,
+			   const std::vector<uint32_t>& indices, uint32_t count, uint32_t& required)
+{
+  std::set< std::tuple<uint32_t, uint32_t, uint32_t> > drawn;
+  for (uint32_t i = 0; i + 2 < count; i += 3) {
+    drawn.insert( std::make_tuple(indices[i], indices[i+1], indices[i+2]) );
+  }
+  uint32_t missing = 0;
+  required = 0;
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    glm::vec3 corners[3];
+    bool inside = false;
+    for (uint32_t j = 0; j < 3; ++j) {
+      glm::vec4 world = model * glm::vec4(mesh.vertices[ mesh.indices[i+j] ], 1.0f);
+      corners[j] = glm::vec3(world);
+      glm::vec4 clip = view_projection * world;
+      inside = inside || ( std::fabs(clip.x) < clip.w && std::fabs(clip.y) < clip.w && std::fabs(clip.z) < clip.w );
+    }
+    glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+    if ( !inside || glm::length(normal) < 1e-7f || glm::dot(normal, camera_position - corners[0]) <= 0 )
+      continue;
+    ++required;
+    if ( !drawn.count( std::make_tuple(mesh.indices[i], mesh.indices[i+1], mesh.indices[i+2]) ) )
+      ++missing;
+  }
+  return missing;
+}
+
+
+int main( void )
+{
+  std::vector<glm::vec3> vertices, normals;
+  std::vector<glm::vec2> uvs;
+  make_sphere(200, 200, vertices, uvs, normals);
+
+  sglMeshletMesh mesh = build_meshlets(vertices, uvs, normals, 64, 124, 1);
+  check( mesh.meshlets.size() >= 256, "sphere needs enough meshlets to use more than one thread" );
+
+  bool within_limits = true, counts_match = true;
+  uint32_t triangles = 0;
+  for (const auto& meshlet: mesh.meshlets) {
+    within_limits = within_limits && meshlet.vertex_count <= 64 && meshlet.triangle_count <= 124 && meshlet.triangle_count > 0;
+    std::vector<uint32_t> used( mesh.indices.begin() + meshlet.index_offset, mesh.indices.begin() + meshlet.index_offset + 3 * meshlet.triangle_count );
+    std::sort(used.begin(), used.end());
+    counts_match = counts_match && std::unique(used.begin(), used.end()) - used.begin() == meshlet.vertex_count;
+    triangles += meshlet.triangle_count;
+  }
+  check( within_limits, "every meshlet has at most 64 vertices and 124 triangles" );
+  check( counts_match, "vertex_count is the number of distinct indices in each meshlet" );
+  check( triangles * 3 == vertices.size() && mesh.indices.size() == vertices.size(), "meshlets cover every triangle once" );
+  check( mesh.vertices.size() < vertices.size() / 3, "duplicate vertices are welded" );
+
+  sglMeshletMesh threaded = build_meshlets(vertices, uvs, normals, 64, 124, 0);
+  check( same_mesh(mesh, threaded), "build_meshlets with threads = 1 and threads = 0 gives the same mesh" );
+
+  const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+  const glm::mat4 identity(1.0f);
+  const glm::mat4 stretched = glm::translate( identity, glm::vec3(0.5f, -0.25f, 0.0f) )
+    * glm::rotate( identity, 0.6f, glm::vec3(0.2f, 1.0f, 0.4f) ) * glm::scale( identity, glm::vec3(3.0f, 0.5f, 1.5f) );
+  struct View { glm::vec3 eye; glm::vec3 target; glm::mat4 model; std::string name; };
+  const View views[] = {
+    { glm::vec3(0.0f, 0.0f, 6.0f), glm::vec3(0.0f), identity, "whole sphere" },
+    { glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(2.2f, 0.0f, 0.0f), identity, "edge of the view" },
+    { glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f), stretched, "non-uniform scale" },
+    { glm::vec3(2.0f, 3.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f), stretched, "non-uniform scale, close up" },
+  };
+
+  for (const auto& view: views) {
+    glm::mat4 view_projection = projection * glm::lookAt( view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f) );
+    std::vector<uint32_t> single, parallel;
+    uint32_t count = cull_meshlets(mesh, view.model, view_projection, view.eye, single, 1);
+    uint32_t parallel_count = cull_meshlets(mesh, view.model, view_projection, view.eye, parallel, 0);
+    check( count == parallel_count && std::equal(single.begin(), single.begin() + count, parallel.begin()),
+	   view.name + ": cull_meshlets with threads = 1 and threads = 0 gives the same indices" );
+
+    uint32_t required = 0;
+    uint32_t missing = missing_triangles(mesh, view.model, view_projection, view.eye, single, count, required);
+    check( required > 0 && missing == 0, view.name + ": all " + std::to_string(required) + " front facing triangles in the view survive, "
+	   + std::to_string(missing) + " missing" );
+    check( count < mesh.indices.size(), view.name + ": some meshlets are culled" );
+
+    // the output holds the visible meshlets in order, so walking both finds every mismatch
+    bool agrees = true;
+    uint32_t offset = 0;
+    for (const auto& meshlet: mesh.meshlets) {
+      if ( !meshlet_visible(meshlet, view.model, view_projection, view.eye) ) continue;
+      uint32_t n_indices = 3 * meshlet.triangle_count;
+      auto first = mesh.indices.begin() + meshlet.index_offset;
+      agrees = agrees && offset + n_indices <= count && std::equal(first, first + n_indices, single.begin() + offset);
+      offset += n_indices;
+    }
+    agrees = agrees && offset == count;
+    check( agrees, view.name + ": meshlet_visible agrees with cull_meshlets" );
+  }
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,412 @@
+/// sgl-meshlet.cpp
+/// Meshlet clustering with per-meshlet bounding sphere / normal cone culling and index buffer compaction
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "sgl-helper.h"
+#include "sgl-meshlet.h"
+#include "sgl-threads.h"
+
+
+namespace {
+
+  //! Chunks smaller than this cost more in hand-off than they save, small meshes are culled on the calling thread.
+  const uint32_t min_chunk_meshlets = 128;
+
+
+  //! Number of chunks for n_meshlets, at most the size of the shared pool.
+  uint32_t meshlet_chunks(uint32_t threads, uint32_t n_meshlets)
+  {
+    return std::min( thread_count(threads, n_meshlets / min_chunk_meshlets), sglThreadPool::shared().size() );
+  }
+
+
+  //! Frustum planes (left, right, bottom, top, near, far) in the space mvp transforms from, pointing inwards.
+  void frustum_planes(const glm::mat4& mvp, glm::vec4 planes[6])
+  {
+    glm::vec4 rows[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+      rows[i] = glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+    }
+    for (uint32_t i = 0; i < 3; ++i) {
+      planes[2*i] = rows[3] + rows[i];
+      planes[2*i + 1] = rows[3] - rows[i];
+    }
+    for (uint32_t i = 0; i < 6; ++i) {
+      float length = glm::length( glm::vec3(planes[i]) );
+      if (length > 0) planes[i] = planes[i] * (1.0f / length);
+    }
+  }
+
+
+  bool sphere_in_frustum(const glm::vec3& center, float radius, const glm::vec4 planes[6])
+  {
+    for (uint32_t i = 0; i < 6; ++i) {
+      if ( glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius )
+	return false;
+    }
+    return true;
+  }
+
+
+  bool cone_visible(const sglMeshlet& meshlet, const glm::vec3& camera)
+  {
+    glm::vec3 to_center = meshlet.center - camera;
+    return glm::dot(to_center, meshlet.cone_axis) < meshlet.cone_cutoff * glm::length(to_center) + meshlet.radius;
+  }
+
+
+  void compute_bounds(const sglMeshletMesh& mesh, sglMeshlet& meshlet)
+  {
+    const uint32_t* indices = &mesh.indices[meshlet.index_offset];
+    uint32_t n_indices = 3 * meshlet.triangle_count;
+
+    glm::vec3 box_min = mesh.vertices[indices[0]];
+    glm::vec3 box_max = box_min;
+    for (uint32_t i = 1; i < n_indices; ++i) {
+      box_min = glm::min(box_min, mesh.vertices[indices[i]]);
+      box_max = glm::max(box_max, mesh.vertices[indices[i]]);
+    }
+    meshlet.center = (box_min + box_max) * 0.5f;
+    meshlet.radius = 0;
+    for (uint32_t i = 0; i < n_indices; ++i) {
+      meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, mesh.vertices[indices[i]]));
+    }
+
+    // normal cone from the geometric normals, counter clockwise is front facing
+    std::vector<glm::vec3> triangle_normals;
+    triangle_normals.reserve(meshlet.triangle_count);
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = 0; i < n_indices; i += 3) {
+      const glm::vec3& a = mesh.vertices[indices[i]];
+      glm::vec3 normal = glm::cross(mesh.vertices[indices[i+1]] - a, mesh.vertices[indices[i+2]] - a);
+      float length = glm::length(normal);
+      if (length <= 0) continue;
+      normal /= length;
+      triangle_normals.push_back(normal);
+      axis += normal;
+    }
+    meshlet.cone_axis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.cone_cutoff = 1;
+    float axis_length = glm::length(axis);
+    if (triangle_normals.empty() || axis_length <= 0) return;
+    axis /= axis_length;
+    float min_dot = 1;
+    for (const auto& normal: triangle_normals) {
+      min_dot = std::min(min_dot, glm::dot(axis, normal));
+    }
+    meshlet.cone_axis = axis;
+    // cones wider than ~84 degrees can't reject anything useful
+    if (min_dot > 0.1f)
+      meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+  }
+
+
+  //! Open addressing hash set of the welded vertices in mesh, 4 bytes per slot and no allocation per vertex.
+  //! Keys are the bit patterns of position, uv and normal, so only exact duplicates are welded.
+  class WeldTable
+  {
+  public:
+    explicit WeldTable(sglMeshletMesh& mesh) : mesh_(mesh), slots_(1024, UINT32_MAX) {}
+
+    //! Index of the vertex equal to (position, uv, normal) in mesh, appended if it isn't there yet.
+    uint32_t insert(const glm::vec3& position, const glm::vec2& uv, const glm::vec3& normal)
+    {
+      // grow at half load so probe sequences stay short
+      if ( 2 * (mesh_.vertices.size() + 1) > slots_.size() )
+	rehash(2 * slots_.size());
+      size_t mask = slots_.size() - 1;
+      for (size_t slot = hash(position, uv, normal) & mask; ; slot = (slot + 1) & mask) {
+	uint32_t index = slots_[slot];
+	if (index == UINT32_MAX) {
+	  index = mesh_.vertices.size();
+	  slots_[slot] = index;
+	  mesh_.vertices.push_back(position);
+	  mesh_.uvs.push_back(uv);
+	  mesh_.normals.push_back(normal);
+	  return index;
+	}
+	if ( mesh_.vertices[index] == position && mesh_.uvs[index] == uv && mesh_.normals[index] == normal )
+	  return index;
+      }
+    }
+
+  private:
+    static uint64_t hash(const glm::vec3& position, const glm::vec2& uv, const glm::vec3& normal)
+    {
+      const float values[8] = {position.x, position.y, position.z, uv.x, uv.y, normal.x, normal.y, normal.z};
+      uint64_t result = 14695981039346656037ull;
+      for (float value: values) {
+	// + 0 turns -0 into 0, they compare equal and have to hash the same
+	value += 0.0f;
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	result = (result ^ bits) * 1099511628211ull;
+      }
+      return result ^ (result >> 32);
+    }
+
+    void rehash(size_t size)
+    {
+      slots_.assign(size, UINT32_MAX);
+      size_t mask = size - 1;
+      for (uint32_t index = 0; index < mesh_.vertices.size(); ++index) {
+	size_t slot = hash(mesh_.vertices[index], mesh_.uvs[index], mesh_.normals[index]) & mask;
+	while (slots_[slot] != UINT32_MAX) slot = (slot + 1) & mask;
+	slots_[slot] = index;
+      }
+    }
+
+    sglMeshletMesh& mesh_;
+    //! Power of two size, UINT32_MAX marks an empty slot.
+    std::vector<uint32_t> slots_;
+  };
+
+
+  //! std430 layout of the meshlet array in meshlet_cull_cs.glsl
+  struct GpuMeshlet
+  {
+    float sphere[4];
+    float cone[4];
+    uint32_t range[4];
+  };
+
+
+  //! Matches DrawElementsIndirectCommand
+  struct DrawCommand
+  {
+    uint32_t count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    uint32_t base_vertex;
+    uint32_t base_instance;
+  };
+
+} // namespace
+
+
+sglMeshletMesh build_meshlets(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals, uint32_t max_vertices, uint32_t max_triangles, uint32_t threads)
+{
+  if ( uvs.size() != vertices.size() || normals.size() != vertices.size() )
+    throw std::runtime_error("[build_meshlets] vertices, uvs and normals must have the same size");
+  if ( max_vertices < 3 || max_triangles == 0 )
+    throw std::runtime_error("[build_meshlets] Meshlets need at least 3 vertices and 1 triangle");
+
+  sglMeshletMesh mesh;
+
+  WeldTable welded(mesh);
+  mesh.indices.reserve(vertices.size());
+  for (uint32_t i = 0; i < vertices.size(); ++i) {
+    mesh.indices.push_back( welded.insert(vertices[i], uvs[i], normals[i]) );
+  }
+
+  // greedy in triangle order, obj exports are usually spatially coherent
+  std::vector<uint32_t> last_meshlet(mesh.vertices.size(), UINT32_MAX);
+  auto count_new_vertices = [&mesh, &last_meshlet](uint32_t first) {
+    uint32_t count = 0;
+    for (uint32_t j = 0; j < 3; ++j) {
+      uint32_t index = mesh.indices[first + j];
+      // degenerate triangles may use the same vertex twice
+      bool repeated = (j > 0 && index == mesh.indices[first]) || (j > 1 && index == mesh.indices[first + 1]);
+      if ( !repeated && last_meshlet[index] != mesh.meshlets.size() ) ++count;
+    }
+    return count;
+  };
+
+  sglMeshlet current;
+  for (uint32_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    uint32_t new_vertices = count_new_vertices(i);
+    if ( current.triangle_count > 0 && (current.vertex_count + new_vertices > max_vertices || current.triangle_count + 1 > max_triangles) ) {
+      mesh.meshlets.push_back(current);
+      current = sglMeshlet();
+      current.index_offset = i;
+      new_vertices = count_new_vertices(i);
+    }
+    for (uint32_t j = 0; j < 3; ++j) {
+      last_meshlet[ mesh.indices[i+j] ] = mesh.meshlets.size();
+    }
+    current.vertex_count += new_vertices;
+    ++current.triangle_count;
+  }
+  if (current.triangle_count > 0)
+    mesh.meshlets.push_back(current);
+
+  uint32_t n_meshlets = mesh.meshlets.size();
+  sglThreadPool::shared().run(n_meshlets, meshlet_chunks(threads, n_meshlets),
+			      [&mesh](uint32_t begin, uint32_t end, uint32_t) {
+				for (uint32_t i = begin; i < end; ++i) {
+				  compute_bounds(mesh, mesh.meshlets[i]);
+				}
+			      });
+  return mesh;
+}
+
+
+bool meshlet_visible(const sglMeshlet& meshlet, const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position)
+{
+  glm::vec4 planes[6];
+  frustum_planes(view_projection * model, planes);
+  glm::vec3 camera = glm::vec3( glm::inverse(model) * glm::vec4(camera_position, 1.0f) );
+  return sphere_in_frustum(meshlet.center, meshlet.radius, planes) && cone_visible(meshlet, camera);
+}
+
+
+uint32_t cull_meshlets(const sglMeshletMesh& mesh, const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position, std::vector<uint32_t>& out_indices, uint32_t threads)
+{
+  glm::vec4 planes[6];
+  frustum_planes(view_projection * model, planes);
+  // Everything is in model space: planes come from view_projection * model and are normalized there, and
+  // center, radius and cone are the untransformed meshlet bounds. Distances change under scaling, so never
+  // mix a world space radius with these planes. The camera is moved into model space for the cone test.
+  glm::vec3 camera = glm::vec3( glm::inverse(model) * glm::vec4(camera_position, 1.0f) );
+
+  out_indices.resize(mesh.indices.size());
+  uint32_t n_meshlets = mesh.meshlets.size();
+  uint32_t n_chunks = meshlet_chunks(threads, n_meshlets);
+  std::vector<uint8_t> visible(n_meshlets);
+  std::vector<uint32_t> chunk_offsets(n_chunks + 1, 0);
+
+  // pass 1: visibility and index count per chunk
+  sglThreadPool::shared().run(n_meshlets, n_chunks,
+			      [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+				uint32_t count = 0;
+				for (uint32_t i = begin; i < end; ++i) {
+				  const sglMeshlet& meshlet = mesh.meshlets[i];
+				  visible[i] = sphere_in_frustum(meshlet.center, meshlet.radius, planes) && cone_visible(meshlet, camera);
+				  if (visible[i]) count += 3 * meshlet.triangle_count;
+				}
+				chunk_offsets[chunk + 1] = count;
+			      });
+  for (uint32_t i = 0; i < n_chunks; ++i) {
+    chunk_offsets[i + 1] += chunk_offsets[i];
+  }
+
+  // pass 2: compaction, each chunk writes behind the preceding ones
+  sglThreadPool::shared().run(n_meshlets, n_chunks,
+			      [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+				uint32_t offset = chunk_offsets[chunk];
+				for (uint32_t i = begin; i < end; ++i) {
+				  if (!visible[i]) continue;
+				  const sglMeshlet& meshlet = mesh.meshlets[i];
+				  auto first = mesh.indices.begin() + meshlet.index_offset;
+				  std::copy(first, first + 3 * meshlet.triangle_count, out_indices.begin() + offset);
+				  offset += 3 * meshlet.triangle_count;
+				}
+			      });
+  return chunk_offsets[n_chunks];
+}
+
+
+sglMeshletCuller::sglMeshletCuller(const sglMeshletMesh& mesh, const std::string& compute_shader_file)
+  : mesh_(mesh)
+{
+  // GL_ELEMENT_ARRAY_BUFFER is part of the bound vertex array, only draw() binds it
+  glGenBuffers(1, &output_indices_);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, output_indices_);
+  glBufferData(GL_COPY_WRITE_BUFFER, mesh_.indices.size()*sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+  if ( !GLEW_VERSION_4_3 ) {
+    std::cout << "[sglMeshletCuller] No compute shader support, culling on the CPU\n";
+    return;
+  }
+
+  GLuint program = program_from_shaders( std::vector<GLuint>{ load_shader(compute_shader_file, GL_COMPUTE_SHADER) } );
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if ( linked != GL_TRUE ) {
+    std::cerr << "[sglMeshletCuller] Couldn't link " << compute_shader_file << ", culling on the CPU\n";
+    glDeleteProgram(program);
+    return;
+  }
+  program_ = program;
+  planes_uniform_ = bind_uniform(program_, "planes");
+  camera_uniform_ = bind_uniform(program_, "camera");
+  count_uniform_ = bind_uniform(program_, "meshlet_count");
+
+  std::vector<GpuMeshlet> meshlets;
+  meshlets.reserve(mesh_.meshlets.size());
+  for (const auto& meshlet: mesh_.meshlets) {
+    GpuMeshlet gpu = { {meshlet.center.x, meshlet.center.y, meshlet.center.z, meshlet.radius},
+		       {meshlet.cone_axis.x, meshlet.cone_axis.y, meshlet.cone_axis.z, meshlet.cone_cutoff},
+		       {meshlet.index_offset, meshlet.triangle_count, 0, 0} };
+    meshlets.push_back(gpu);
+  }
+  glGenBuffers(1, &meshlet_buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshlet_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, meshlets.size()*sizeof(GpuMeshlet), meshlets.data(), GL_STATIC_DRAW);
+
+  glGenBuffers(1, &source_indices_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, source_indices_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, mesh_.indices.size()*sizeof(uint32_t), mesh_.indices.data(), GL_STATIC_DRAW);
+
+  glGenBuffers(1, &command_buffer_);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+}
+
+
+sglMeshletCuller::~sglMeshletCuller()
+{
+  GLuint buffers[] = {meshlet_buffer_, source_indices_, output_indices_, command_buffer_};
+  for (auto buffer: buffers) {
+    if (buffer) glDeleteBuffers(1, &buffer);
+  }
+  if (program_) glDeleteProgram(program_);
+}
+
+
+void sglMeshletCuller::cull(const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position)
+{
+  if ( !use_gpu() ) {
+    culled_count_ = cull_meshlets(mesh_, model, view_projection, camera_position, culled_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, output_indices_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, culled_count_*sizeof(uint32_t), culled_.data());
+    return;
+  }
+
+  glm::vec4 planes[6];
+  frustum_planes(view_projection * model, planes);
+  glm::vec3 camera = glm::vec3( glm::inverse(model) * glm::vec4(camera_position, 1.0f) );
+
+  DrawCommand command = {0, 1, 0, 0, 0};
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+
+  GLint previous_program = 0;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+  glUseProgram(program_);
+  glUniform4fv(planes_uniform_, 6, glm::value_ptr(planes[0]));
+  glUniform3f(camera_uniform_, camera.x, camera.y, camera.z);
+  glUniform1ui(count_uniform_, mesh_.meshlets.size());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, meshlet_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, source_indices_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, output_indices_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, command_buffer_);
+  glDispatchCompute( (mesh_.meshlets.size() + 63) / 64, 1, 1 );
+  glMemoryBarrier(GL_ELEMENT_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+  glUseProgram(previous_program);
+}
+
+
+void sglMeshletCuller::draw()
+{
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, output_indices_);
+  if ( !use_gpu() ) {
+    glDrawElements(GL_TRIANGLES, culled_count_, GL_UNSIGNED_INT, 0);
+    return;
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+  glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0);
+}
@@ -0,0 +1,93 @@
+/// sgl-meshlet.h
+/// Meshlet clustering with per-meshlet bounding sphere / normal cone culling and index buffer compaction
+/// author: Ulrike Hager
+
+#ifndef SGL_MESHLET
+#define SGL_MESHLET
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+
+//! Triangles [index_offset/3, index_offset/3 + triangle_count) of the mesh index buffer, using vertex_count distinct vertices.
+struct sglMeshlet
+{
+  uint32_t index_offset = 0;
+  uint32_t triangle_count = 0;
+  uint32_t vertex_count = 0;
+  glm::vec3 center;
+  float radius = 0;
+  //! Meshlet is back facing if dot(center - camera, cone_axis) >= cone_cutoff * |center - camera| + radius.
+  //! cone_cutoff = 1 disables the test (normals spread too far).
+  glm::vec3 cone_axis;
+  float cone_cutoff = 1;
+};
+
+
+//! Indexed mesh with triangles grouped by meshlet.
+struct sglMeshletMesh
+{
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec3> normals;
+  std::vector<uint32_t> indices;
+  std::vector<sglMeshlet> meshlets;
+};
+
+
+//! Welds the triangle soup returned by load_blender_obj into an indexed mesh and partitions the triangles in file order into meshlets.
+//! Bounds and cones are computed in parallel over meshlets on the shared worker pool. threads = 0 uses all pool threads.
+//! Meshes with fewer than 256 meshlets are processed on the calling thread.
+sglMeshletMesh build_meshlets(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals, uint32_t max_vertices = 64, uint32_t max_triangles = 124, uint32_t threads = 0);
+
+//! True unless the meshlet is outside the view frustum or faces away from the camera.
+//! Both tests are done in model space (planes, bounds and camera), camera_position is passed in world space.
+bool meshlet_visible(const sglMeshlet& meshlet, const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position);
+
+//! Writes the indices of all visible meshlets into out_indices (resized to mesh.indices.size()), returns the number of indices written.
+//! Threads as in build_meshlets().
+uint32_t cull_meshlets(const sglMeshletMesh& mesh, const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position, std::vector<uint32_t>& out_indices, uint32_t threads = 0);
+
+
+//! Owns the GL buffers for meshlet culling. Uses a compute shader (GLSL 4.30, std430 storage buffers) if the context
+//! is OpenGL 4.3 or newer, cull_meshlets() + glBufferSubData otherwise.
+//! Vertex attributes are left to the caller, bind the vertex array before draw(). mesh must outlive the culler.
+//! Only draw() touches vertex array state: it binds the culled indices as the element buffer of the bound vertex array.
+//! cull() keeps the current program; it changes the GL_COPY_WRITE_BUFFER, GL_DRAW_INDIRECT_BUFFER and storage buffer bindings.
+class sglMeshletCuller
+{
+ public:
+  sglMeshletCuller(const sglMeshletMesh& mesh, const std::string& compute_shader_file = "meshlet_cull_cs.glsl");
+  sglMeshletCuller(const sglMeshletCuller& toCopy) = delete;
+  sglMeshletCuller& operator=(const sglMeshletCuller& toCopy) = delete;
+  ~sglMeshletCuller();
+
+  void cull(const glm::mat4& model, const glm::mat4& view_projection, const glm::vec3& camera_position);
+  //! Draws the triangles that survived the last cull().
+  void draw();
+
+  bool use_gpu() const {return program_ != 0;}
+  GLuint index_buffer() const {return output_indices_;}
+
+ private:
+  const sglMeshletMesh& mesh_;
+  GLuint program_ = 0;
+  GLuint meshlet_buffer_ = 0;
+  GLuint source_indices_ = 0;
+  GLuint output_indices_ = 0;
+  GLuint command_buffer_ = 0;
+  GLint planes_uniform_ = -1;
+  GLint camera_uniform_ = -1;
+  GLint count_uniform_ = -1;
+  //! CPU path only
+  std::vector<uint32_t> culled_;
+  uint32_t culled_count_ = 0;
+};
+
+
+#endif //  SGL_MESHLET
@@ -0,0 +1,155 @@
+/// sgl-obj-test.cpp
+/// Checks load_blender_obj_stream against load_blender_obj_fscan for small blocks and odd files, exits non-zero on failure
+/// author: Ulrike Hager
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sgl-helper.h"
+
+int failures = 0;
+
+const std::string mushroom_file = "resources/mushroom.obj";
+
+
+void check(bool condition, const std::string& what)
+{
+  std::cout << (condition ? "pass: " : "FAIL: ") << what << std::endl;
+  if (!condition) ++failures;
+}
+
+
+//! Concatenated output of load_blender_obj_stream. batches_ok is false if a batch other than the last one
+//! has fewer than batch_triangles triangles, or any batch is empty.
+sglMeshBatch stream(const std::string& file, uint32_t batch_triangles, size_t block_size, bool& batches_ok)
+{
+  sglMeshBatch result;
+  std::vector<size_t> sizes;
+  load_blender_obj_stream(file, batch_triangles,
+			  [&](const sglMeshBatch& batch) {
+			    result.vertices.insert(result.vertices.end(), batch.vertices.begin(), batch.vertices.end());
+			    result.uvs.insert(result.uvs.end(), batch.uvs.begin(), batch.uvs.end());
+			    result.normals.insert(result.normals.end(), batch.normals.begin(), batch.normals.end());
+			    sizes.push_back(batch.vertices.size());
+			  },
+			  block_size);
+  batches_ok = true;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    batches_ok = batches_ok && sizes[i] > 0 && sizes[i] % 3 == 0 && ( i + 1 == sizes.size() || sizes[i] >= 3 * (size_t)batch_triangles );
+  }
+  return result;
+}
+
+
+bool same(const sglMeshBatch& batch, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals)
+{
+  return batch.vertices == vertices && batch.uvs == uvs && batch.normals == normals;
+}
+
+
+std::string read_file(const std::string& file)
+{
+  std::ifstream input(file, std::ios::binary);
+  std::stringstream content;
+  content << input.rdbuf();
+  return content.str();
+}
+
+
+void write_file(const std::string& file, const std::string& content)
+{
+  std::ofstream output(file, std::ios::binary);
+  output << content;
+}
+
+
+int main( void )
+{
+  std::vector<glm::vec3> vertices, normals;
+  std::vector<glm::vec2> uvs;
+  load_blender_obj_fscan(mushroom_file, vertices, uvs, normals);
+  check( !vertices.empty(), "fscan loads " + mushroom_file );
+
+  // blocks from barely longer than the longest line (50 characters) up to the default
+  const size_t block_sizes[] = {51, 64, 97, 1000, 65536};
+  const uint32_t batch_sizes[] = {1, 7, 140, 100000};
+  for (size_t block_size: block_sizes) {
+    bool all_same = true, all_batches_ok = true;
+    for (uint32_t batch_triangles: batch_sizes) {
+      bool batches_ok = false;
+      all_same = all_same && same( stream(mushroom_file, batch_triangles, block_size, batches_ok), vertices, uvs, normals );
+      all_batches_ok = all_batches_ok && batches_ok;
+    }
+    check( all_same, "block size " + std::to_string(block_size) + ": stream matches fscan for batches of 1, 7, 140, 100000 triangles" );
+    check( all_batches_ok, "block size " + std::to_string(block_size) + ": every batch but the last is full" );
+  }
+
+  // CRLF line endings and no newline after the last face
+  std::string content = read_file(mushroom_file), crlf;
+  for (char c: content) {
+    if (c == '\n') crlf += '\r';
+    crlf += c;
+  }
+  while ( !crlf.empty() && (crlf.back() == '\n' || crlf.back() == '\r') ) crlf.pop_back();
+  const std::string crlf_file = "sgl-obj-test-crlf.obj";
+  write_file(crlf_file, crlf);
+  bool crlf_same = true, batches_ok = false;
+  for (size_t block_size: {53, 64, 65536}) {
+    crlf_same = crlf_same && same( stream(crlf_file, 7, block_size, batches_ok), vertices, uvs, normals );
+  }
+  check( crlf_same, "CRLF file without final newline matches fscan of the original" );
+
+  // negative indices, fans, comments and a line longer than the block
+  const std::string fan_file = "sgl-obj-test-fan.obj";
+  write_file(fan_file,
+	     "# " + std::string(100, 'x') + "\n"
+	     "o quad_and_pentagon\n"
+	     "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+	     "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+	     "vn 0 0 1\n"
+	     "s off\n"
+	     "f -4/-4/-1 -3/-3/-1 -2/-2/-1 -1/-1/-1\n"
+	     "v 2 0 0\n"
+	     "f 1/1/1 2/2/1 -1/3/1 3/3/1 4/4/1");
+  const glm::vec3 p[] = { glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 1, 0), glm::vec3(0, 1, 0), glm::vec3(2, 0, 0) };
+  const glm::vec2 t[] = { glm::vec2(0, 0), glm::vec2(1, 0), glm::vec2(1, -1), glm::vec2(0, -1) };
+  // fans around the first corner: quad 0 1 2 3, pentagon 0 1 4 2 3
+  const int expected_vertices[] = {0, 1, 2,  0, 2, 3,  0, 1, 4,  0, 4, 2,  0, 2, 3};
+  const int expected_uvs[] = {0, 1, 2,  0, 2, 3,  0, 1, 2,  0, 2, 2,  0, 2, 3};
+  std::vector<glm::vec3> fan_vertices, fan_normals(15, glm::vec3(0, 0, 1));
+  std::vector<glm::vec2> fan_uvs;
+  for (int i = 0; i < 15; ++i) {
+    fan_vertices.push_back( p[ expected_vertices[i] ] );
+    fan_uvs.push_back( t[ expected_uvs[i] ] );
+  }
+  bool fan_same = true;
+  for (uint32_t batch_triangles: {1u, 2u, 100u}) {
+    fan_same = fan_same && same( stream(fan_file, batch_triangles, 128, batches_ok), fan_vertices, fan_uvs, fan_normals );
+  }
+  check( fan_same, "negative indices and fan triangulation of a quad and a pentagon" );
+
+  bool thrown = false;
+  try {
+    stream(fan_file, 100, 64, batches_ok);
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  check( thrown, "line longer than the block size throws" );
+
+  std::remove( crlf_file.c_str() );
+  std::remove( fan_file.c_str() );
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
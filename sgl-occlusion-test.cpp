@@ -0,0 +1,113 @@
+/// sgl-occlusion-test.cpp
+/// Checks sglOcclusionCuller without a window or GL context, exits non-zero on failure
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "sglOcclusionCuller.h"
+
+int failures = 0;
+
+
+void check(bool condition, const std::string& what)
+{
+  std::cout << (condition ? "pass: " : "FAIL: ") << what << std::endl;
+  if (!condition) ++failures;
+}
+
+
+sglAABB box(glm::vec3 min, glm::vec3 max)
+{
+  sglAABB result;
+  result.min = min;
+  result.max = max;
+  return result;
+}
+
+
+int main( void )
+{
+  // camera at the origin looking down -z, occluder is a 4x4 quad at z = -5
+  const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+  const glm::mat4 identity(1.0f);
+  std::vector<glm::vec3> quad = { {-2.0f, -2.0f, -5.0f}, {2.0f, -2.0f, -5.0f}, {2.0f, 2.0f, -5.0f},
+				  {-2.0f, -2.0f, -5.0f}, {2.0f, 2.0f, -5.0f}, {-2.0f, 2.0f, -5.0f} };
+  sglOccluder occluder = make_occluder(quad);
+  check(occluder.vertices.size() == 4 && occluder.indices.size() == 6, "make_occluder welds the quad into 4 vertices, 2 triangles");
+
+  const sglAABB behind = box( glm::vec3(-0.5f, -0.5f, -9.0f), glm::vec3(0.5f, 0.5f, -8.0f) );
+  const sglAABB in_front = box( glm::vec3(-0.5f, -0.5f, -3.0f), glm::vec3(0.5f, 0.5f, -2.5f) );
+  const sglAABB off_screen = box( glm::vec3(50.0f, -0.5f, -6.0f), glm::vec3(51.0f, 0.5f, -5.5f) );
+  const sglAABB near_plane = box( glm::vec3(-0.5f, -0.5f, -9.0f), glm::vec3(0.5f, 0.5f, 1.0f) );
+  const sglAABB beside = box( glm::vec3(1.5f, -0.5f, -9.0f), glm::vec3(6.0f, 0.5f, -8.0f) );
+  const std::vector<sglAABB> boxes = {behind, in_front, off_screen, near_plane, beside};
+
+  sglOcclusionCuller single(256, 128, 1);
+  sglOcclusionCuller threaded(256, 128, 4);
+  sglOcclusionCuller* cullers[] = {&single, &threaded};
+  for (auto culler: cullers) {
+    culler->begin_frame(projection);
+    culler->add_occluder(occluder, identity);
+    culler->rasterize();
+  }
+
+  check( !single.is_visible(behind, identity), "box behind the occluder is hidden" );
+  check( single.is_visible(in_front, identity), "box in front of the occluder is visible" );
+  check( !single.is_visible(off_screen, identity), "box outside the view is culled" );
+  check( single.is_visible(near_plane, identity), "box crossing the near plane is visible" );
+  check( single.is_visible(beside, identity), "box partly beside the occluder is visible" );
+  glm::mat4 move_behind = glm::translate(identity, glm::vec3(0.0f, 0.0f, -6.0f));
+  check( !single.is_visible(in_front, move_behind), "model matrix is applied to the box" );
+
+  // depth buffer and Hi-Z
+  glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -5.0f, 1.0f);
+  float expected = clip.z / clip.w * 0.5f + 0.5f;
+  uint32_t centre_x = single.width() / 2, centre_y = single.height() / 2;
+  check( std::fabs(single.depth(centre_x, centre_y) - expected) < 1e-4f, "depth at the centre matches the occluder plane" );
+  check( single.depth(0, 0) == 1.0f, "uncovered corner keeps the cleared depth" );
+  bool hiz_ok = true;
+  for (uint32_t level = 1; level < single.levels(); ++level) {
+    for (uint32_t y = 0; y < single.height(level); ++y) {
+      for (uint32_t x = 0; x < single.width(level); ++x) {
+	float farthest = 0;
+	for (uint32_t j = 0; j < 2; ++j) {
+	  for (uint32_t i = 0; i < 2; ++i) {
+	    uint32_t below_x = std::min(2*x + i, single.width(level-1) - 1);
+	    uint32_t below_y = std::min(2*y + j, single.height(level-1) - 1);
+	    farthest = std::max(farthest, single.depth(below_x, below_y, level-1));
+	  }
+	}
+	hiz_ok = hiz_ok && single.depth(x, y, level) == farthest;
+      }
+    }
+  }
+  check( hiz_ok, "every Hi-Z texel is the farthest of the 2x2 texels below" );
+  check( single.width(single.levels()-1) == 1 && single.height(single.levels()-1) == 1, "Hi-Z ends in a single texel" );
+  check( std::fabs(single.depth(centre_x / 4, centre_y / 4, 2) - expected) < 1e-4f, "Hi-Z level 2 inside the occluder keeps its depth" );
+
+  // threads = 1 and threads = N must give the same buffer
+  bool same_depth = true;
+  for (uint32_t y = 0; y < single.height(); ++y) {
+    for (uint32_t x = 0; x < single.width(); ++x) {
+      same_depth = same_depth && single.depth(x, y) == threaded.depth(x, y);
+    }
+  }
+  check( same_depth, "1 and 4 threads produce the same depth buffer" );
+  std::vector<uint8_t> visible_single, visible_threaded;
+  single.test(boxes, visible_single);
+  threaded.test(boxes, visible_threaded);
+  check( visible_single == visible_threaded, "1 and 4 threads give the same visibility" );
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
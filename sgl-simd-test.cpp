@@ -0,0 +1,161 @@
+/// sgl-simd-test.cpp
+/// Checks the sgl-simd kernels against scalar glm loops at every supported level, exits non-zero on failure
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "sgl-bounds.h"
+#include "sgl-simd.h"
+
+int failures = 0;
+
+//! Empty input and the scalar tails behind 4, 8 and 16 wide vectors.
+const size_t sizes[] = {0, 1, 3, 7, 9, 15, 17};
+
+
+void check(bool condition, const std::string& what)
+{
+  std::cout << (condition ? "pass: " : "FAIL: ") << what << std::endl;
+  if (!condition) ++failures;
+}
+
+
+bool close(float value, float reference, float tolerance)
+{
+  return std::fabs(value - reference) <= tolerance * std::max(1.0f, std::fabs(reference));
+}
+
+
+bool matches(const sglSoA3& soa, const std::vector<glm::vec3>& reference, float tolerance)
+{
+  if (soa.size() != reference.size()) return false;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    if ( !close(soa.x[i], reference[i].x, tolerance) || !close(soa.y[i], reference[i].y, tolerance) || !close(soa.z[i], reference[i].z, tolerance) )
+      return false;
+  }
+  return true;
+}
+
+
+bool matches(const sglSoA2& soa, const std::vector<glm::vec2>& reference, float tolerance)
+{
+  if (soa.size() != reference.size()) return false;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    if ( !close(soa.x[i], reference[i].x, tolerance) || !close(soa.y[i], reference[i].y, tolerance) )
+      return false;
+  }
+  return true;
+}
+
+
+bool same_box(const sglAABB& box, const sglAABB& reference)
+{
+  return box.min == reference.min && box.max == reference.max;
+}
+
+
+std::vector<glm::vec3> random_vec3(size_t n, std::mt19937& generator, float low, float high)
+{
+  std::uniform_real_distribution<float> distribution(low, high);
+  std::vector<glm::vec3> result(n);
+  for (auto& vector: result) {
+    vector = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+  }
+  return result;
+}
+
+
+//! Adds " n" to failed_sizes if condition is false.
+void record(bool condition, size_t n, std::string& failed_sizes)
+{
+  if (!condition) failed_sizes += " " + std::to_string(n);
+}
+
+
+void report(const std::string& what, const std::string& failed_sizes)
+{
+  check( failed_sizes.empty(), what + (failed_sizes.empty() ? "" : ", fails for n =" + failed_sizes) );
+}
+
+
+int main( void )
+{
+  const glm::mat4 matrix = glm::translate( glm::mat4(1.0f), glm::vec3(1.0f, -2.0f, 3.0f) )
+    * glm::rotate( glm::mat4(1.0f), 0.7f, glm::vec3(0.3f, 1.0f, 0.2f) ) * glm::scale( glm::mat4(1.0f), glm::vec3(1.5f, 0.5f, 2.0f) );
+  const glm::vec2 uv_scale(1.0f, -1.0f), uv_offset(0.25f, 1.0f);
+  const float tolerance = 1e-5f;
+
+  for (int level = 0; level <= static_cast<int>( simd_supported() ); ++level) {
+    set_simd_level( static_cast<sglSimdLevel>(level) );
+    const std::string name = simd_level_name( simd_level() );
+    check( simd_level() == static_cast<sglSimdLevel>(level), name + ": selected by set_simd_level" );
+    std::string transform_failed, aabb_failed, negative_failed, equal_failed, normalize_failed, zero_failed, uv_failed;
+
+    for (size_t n: sizes) {
+      std::mt19937 generator(42 + n);
+
+      std::vector<glm::vec3> points = random_vec3(n, generator, -10.0f, 10.0f);
+      std::vector<glm::vec3> reference = points;
+      for (auto& point: reference) point = glm::vec3( matrix * glm::vec4(point, 1.0f) );
+      sglSoA3 soa = to_soa(points);
+      transform_points(matrix, soa);
+      record( matches(soa, reference, tolerance), n, transform_failed );
+
+      record( same_box( compute_aabb(to_soa(points)), compute_aabb(points) ), n, aabb_failed );
+      std::vector<glm::vec3> negative = random_vec3(n, generator, -10.0f, -1.0f);
+      record( same_box( compute_aabb(to_soa(negative)), compute_aabb(negative) ), n, negative_failed );
+      std::vector<glm::vec3> equal(n, glm::vec3(-3.0f, 2.0f, -0.5f));
+      record( same_box( compute_aabb(to_soa(equal)), compute_aabb(equal) ), n, equal_failed );
+
+      // zero length normals in the vector body and in the tail, not only at index 0
+      std::vector<glm::vec3> normals = random_vec3(n, generator, -10.0f, 10.0f);
+      for (size_t i = 3; i < n; i += 5) normals[i] = glm::vec3(0.0f);
+      if (n > 1) normals[n-1] = glm::vec3(0.0f);
+      reference = normals;
+      for (auto& normal: reference) {
+	float length = glm::length(normal);
+	normal = length > 0 ? normal / length : normal;
+      }
+      soa = to_soa(normals);
+      normalize_vectors(soa);
+      record( matches(soa, reference, tolerance), n, normalize_failed );
+      bool zeros_kept = true;
+      for (size_t i = 0; i < n; ++i) {
+	if ( normals[i] == glm::vec3(0.0f) )
+	  zeros_kept = zeros_kept && soa.x[i] == 0.0f && soa.y[i] == 0.0f && soa.z[i] == 0.0f;
+      }
+      record( zeros_kept, n, zero_failed );
+
+      std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+      std::vector<glm::vec2> uvs(n);
+      for (auto& uv: uvs) uv = glm::vec2(distribution(generator), distribution(generator));
+      std::vector<glm::vec2> reference_uvs = uvs;
+      for (auto& uv: reference_uvs) uv = uv * uv_scale + uv_offset;
+      sglSoA2 soa_uvs = to_soa(uvs);
+      transform_uvs(soa_uvs, uv_scale, uv_offset);
+      record( matches(soa_uvs, reference_uvs, tolerance), n, uv_failed );
+    }
+
+    report(name + ": transform_points matches glm", transform_failed);
+    report(name + ": compute_aabb matches the scalar box", aabb_failed);
+    report(name + ": compute_aabb with all points negative", negative_failed);
+    report(name + ": compute_aabb with all points equal", equal_failed);
+    report(name + ": normalize_vectors matches glm", normalize_failed);
+    report(name + ": zero length vectors stay zero", zero_failed);
+    report(name + ": transform_uvs matches glm", uv_failed);
+  }
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
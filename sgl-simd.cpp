@@ -0,0 +1,461 @@
+/// sgl-simd.cpp
+/// Bulk vertex kernels on structure-of-arrays copies of loader output, with runtime instruction set dispatch
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sgl-simd.h"
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && ( defined(__GNUC__) || defined(__clang__) )
+#define SGL_SIMD_X86
+// GCC 12 avx512fintrin.h passes _mm512_undefined_ps() to the builtins, which trips -Wmaybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+
+namespace {
+
+  //! Matrix is column major like glm: m[4*column + row]. aabb() extends min/max instead of overwriting them.
+  struct Kernels
+  {
+    void (*transform_points)(const float* m, float* x, float* y, float* z, size_t n);
+    void (*aabb)(const float* x, const float* y, const float* z, size_t n, float* min, float* max);
+    void (*normalize)(float* x, float* y, float* z, size_t n);
+    void (*uvs)(float* u, float* v, size_t n, float scale_u, float scale_v, float offset_u, float offset_v);
+  };
+
+
+  ////////////////////
+  ////   scalar   ////
+  ////////////////////
+  void transform_points_scalar(const float* m, float* x, float* y, float* z, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      float px = x[i], py = y[i], pz = z[i];
+      x[i] = m[0]*px + m[4]*py + m[8]*pz + m[12];
+      y[i] = m[1]*px + m[5]*py + m[9]*pz + m[13];
+      z[i] = m[2]*px + m[6]*py + m[10]*pz + m[14];
+    }
+  }
+
+
+  void aabb_scalar(const float* x, const float* y, const float* z, size_t n, float* min, float* max)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      min[0] = std::min(min[0], x[i]);
+      min[1] = std::min(min[1], y[i]);
+      min[2] = std::min(min[2], z[i]);
+      max[0] = std::max(max[0], x[i]);
+      max[1] = std::max(max[1], y[i]);
+      max[2] = std::max(max[2], z[i]);
+    }
+  }
+
+
+  void normalize_scalar(float* x, float* y, float* z, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      float length = std::sqrt(x[i]*x[i] + y[i]*y[i] + z[i]*z[i]);
+      float inverse = length > 0 ? 1.0f / length : 0.0f;
+      x[i] *= inverse;
+      y[i] *= inverse;
+      z[i] *= inverse;
+    }
+  }
+
+
+  void uvs_scalar(float* u, float* v, size_t n, float scale_u, float scale_v, float offset_u, float offset_v)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      u[i] = u[i] * scale_u + offset_u;
+      v[i] = v[i] * scale_v + offset_v;
+    }
+  }
+
+
+  const Kernels scalar_kernels = { transform_points_scalar, aabb_scalar, normalize_scalar, uvs_scalar };
+
+
+#ifdef SGL_SIMD_X86
+  ////////////////////
+  ////  SSE4.1    ////
+  ////////////////////
+  __attribute__((target("sse4.1")))
+  void transform_points_sse4(const float* m, float* x, float* y, float* z, size_t n)
+  {
+    __m128 c[16];
+    for (uint32_t j = 0; j < 16; ++j) c[j] = _mm_set1_ps(m[j]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+      for (uint32_t r = 0; r < 3; ++r) {
+	__m128 result = _mm_add_ps( _mm_add_ps(_mm_mul_ps(c[r], px), _mm_mul_ps(c[4+r], py)),
+				    _mm_add_ps(_mm_mul_ps(c[8+r], pz), c[12+r]) );
+	_mm_storeu_ps( (r == 0 ? x : r == 1 ? y : z) + i, result );
+      }
+    }
+    transform_points_scalar(m, x + i, y + i, z + i, n - i);
+  }
+
+
+  __attribute__((target("sse4.1")))
+  void aabb_sse4(const float* x, const float* y, const float* z, size_t n, float* min, float* max)
+  {
+    const float* axes[3] = {x, y, z};
+    size_t n_vector = n & ~size_t(3);
+    for (uint32_t a = 0; a < 3; ++a) {
+      if (n_vector == 0) break;
+      __m128 low = _mm_set1_ps(min[a]), high = _mm_set1_ps(max[a]);
+      for (size_t i = 0; i < n_vector; i += 4) {
+	__m128 value = _mm_loadu_ps(axes[a] + i);
+	low = _mm_min_ps(low, value);
+	high = _mm_max_ps(high, value);
+      }
+      float lows[4], highs[4];
+      _mm_storeu_ps(lows, low);
+      _mm_storeu_ps(highs, high);
+      min[a] = *std::min_element(lows, lows + 4);
+      max[a] = *std::max_element(highs, highs + 4);
+    }
+    aabb_scalar(x + n_vector, y + n_vector, z + n_vector, n - n_vector, min, max);
+  }
+
+
+  __attribute__((target("sse4.1")))
+  void normalize_sse4(float* x, float* y, float* z, size_t n)
+  {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+      __m128 length = _mm_sqrt_ps( _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)) );
+      __m128 inverse = _mm_blendv_ps(zero, _mm_div_ps(one, length), _mm_cmpgt_ps(length, zero));
+      _mm_storeu_ps(x + i, _mm_mul_ps(vx, inverse));
+      _mm_storeu_ps(y + i, _mm_mul_ps(vy, inverse));
+      _mm_storeu_ps(z + i, _mm_mul_ps(vz, inverse));
+    }
+    normalize_scalar(x + i, y + i, z + i, n - i);
+  }
+
+
+  __attribute__((target("sse4.1")))
+  void uvs_sse4(float* u, float* v, size_t n, float scale_u, float scale_v, float offset_u, float offset_v)
+  {
+    const __m128 su = _mm_set1_ps(scale_u), sv = _mm_set1_ps(scale_v), ou = _mm_set1_ps(offset_u), ov = _mm_set1_ps(offset_v);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      _mm_storeu_ps(u + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(u + i), su), ou));
+      _mm_storeu_ps(v + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v + i), sv), ov));
+    }
+    uvs_scalar(u + i, v + i, n - i, scale_u, scale_v, offset_u, offset_v);
+  }
+
+
+  const Kernels sse4_kernels = { transform_points_sse4, aabb_sse4, normalize_sse4, uvs_sse4 };
+
+
+  ////////////////////
+  ////    AVX2    ////
+  ////////////////////
+  __attribute__((target("avx2")))
+  void transform_points_avx2(const float* m, float* x, float* y, float* z, size_t n)
+  {
+    __m256 c[16];
+    for (uint32_t j = 0; j < 16; ++j) c[j] = _mm256_set1_ps(m[j]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+      for (uint32_t r = 0; r < 3; ++r) {
+	__m256 result = _mm256_add_ps( _mm256_add_ps(_mm256_mul_ps(c[r], px), _mm256_mul_ps(c[4+r], py)),
+				       _mm256_add_ps(_mm256_mul_ps(c[8+r], pz), c[12+r]) );
+	_mm256_storeu_ps( (r == 0 ? x : r == 1 ? y : z) + i, result );
+      }
+    }
+    transform_points_scalar(m, x + i, y + i, z + i, n - i);
+  }
+
+
+  __attribute__((target("avx2")))
+  void aabb_avx2(const float* x, const float* y, const float* z, size_t n, float* min, float* max)
+  {
+    const float* axes[3] = {x, y, z};
+    size_t n_vector = n & ~size_t(7);
+    for (uint32_t a = 0; a < 3; ++a) {
+      if (n_vector == 0) break;
+      __m256 low = _mm256_set1_ps(min[a]), high = _mm256_set1_ps(max[a]);
+      for (size_t i = 0; i < n_vector; i += 8) {
+	__m256 value = _mm256_loadu_ps(axes[a] + i);
+	low = _mm256_min_ps(low, value);
+	high = _mm256_max_ps(high, value);
+      }
+      float lows[8], highs[8];
+      _mm256_storeu_ps(lows, low);
+      _mm256_storeu_ps(highs, high);
+      min[a] = *std::min_element(lows, lows + 8);
+      max[a] = *std::max_element(highs, highs + 8);
+    }
+    aabb_scalar(x + n_vector, y + n_vector, z + n_vector, n - n_vector, min, max);
+  }
+
+
+  __attribute__((target("avx2")))
+  void normalize_avx2(float* x, float* y, float* z, size_t n)
+  {
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+      __m256 length = _mm256_sqrt_ps( _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)) );
+      __m256 inverse = _mm256_blendv_ps(zero, _mm256_div_ps(one, length), _mm256_cmp_ps(length, zero, _CMP_GT_OQ));
+      _mm256_storeu_ps(x + i, _mm256_mul_ps(vx, inverse));
+      _mm256_storeu_ps(y + i, _mm256_mul_ps(vy, inverse));
+      _mm256_storeu_ps(z + i, _mm256_mul_ps(vz, inverse));
+    }
+    normalize_scalar(x + i, y + i, z + i, n - i);
+  }
+
+
+  __attribute__((target("avx2")))
+  void uvs_avx2(float* u, float* v, size_t n, float scale_u, float scale_v, float offset_u, float offset_v)
+  {
+    const __m256 su = _mm256_set1_ps(scale_u), sv = _mm256_set1_ps(scale_v), ou = _mm256_set1_ps(offset_u), ov = _mm256_set1_ps(offset_v);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      _mm256_storeu_ps(u + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(u + i), su), ou));
+      _mm256_storeu_ps(v + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(v + i), sv), ov));
+    }
+    uvs_scalar(u + i, v + i, n - i, scale_u, scale_v, offset_u, offset_v);
+  }
+
+
+  const Kernels avx2_kernels = { transform_points_avx2, aabb_avx2, normalize_avx2, uvs_avx2 };
+
+
+  ////////////////////
+  ////  AVX-512   ////
+  ////////////////////
+  __attribute__((target("avx512f")))
+  void transform_points_avx512(const float* m, float* x, float* y, float* z, size_t n)
+  {
+    __m512 c[16];
+    for (uint32_t j = 0; j < 16; ++j) c[j] = _mm512_set1_ps(m[j]);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m512 px = _mm512_loadu_ps(x + i), py = _mm512_loadu_ps(y + i), pz = _mm512_loadu_ps(z + i);
+      for (uint32_t r = 0; r < 3; ++r) {
+	__m512 result = _mm512_add_ps( _mm512_add_ps(_mm512_mul_ps(c[r], px), _mm512_mul_ps(c[4+r], py)),
+				       _mm512_add_ps(_mm512_mul_ps(c[8+r], pz), c[12+r]) );
+	_mm512_storeu_ps( (r == 0 ? x : r == 1 ? y : z) + i, result );
+      }
+    }
+    transform_points_scalar(m, x + i, y + i, z + i, n - i);
+  }
+
+
+  __attribute__((target("avx512f")))
+  void aabb_avx512(const float* x, const float* y, const float* z, size_t n, float* min, float* max)
+  {
+    const float* axes[3] = {x, y, z};
+    size_t n_vector = n & ~size_t(15);
+    for (uint32_t a = 0; a < 3; ++a) {
+      if (n_vector == 0) break;
+      __m512 low = _mm512_set1_ps(min[a]), high = _mm512_set1_ps(max[a]);
+      for (size_t i = 0; i < n_vector; i += 16) {
+	__m512 value = _mm512_loadu_ps(axes[a] + i);
+	low = _mm512_min_ps(low, value);
+	high = _mm512_max_ps(high, value);
+      }
+      min[a] = _mm512_reduce_min_ps(low);
+      max[a] = _mm512_reduce_max_ps(high);
+    }
+    aabb_scalar(x + n_vector, y + n_vector, z + n_vector, n - n_vector, min, max);
+  }
+
+
+  __attribute__((target("avx512f")))
+  void normalize_avx512(float* x, float* y, float* z, size_t n)
+  {
+    const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m512 vx = _mm512_loadu_ps(x + i), vy = _mm512_loadu_ps(y + i), vz = _mm512_loadu_ps(z + i);
+      __m512 length = _mm512_sqrt_ps( _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)), _mm512_mul_ps(vz, vz)) );
+      __mmask16 nonzero = _mm512_cmp_ps_mask(length, zero, _CMP_GT_OQ);
+      __m512 inverse = _mm512_maskz_div_ps(nonzero, one, length);
+      _mm512_storeu_ps(x + i, _mm512_mul_ps(vx, inverse));
+      _mm512_storeu_ps(y + i, _mm512_mul_ps(vy, inverse));
+      _mm512_storeu_ps(z + i, _mm512_mul_ps(vz, inverse));
+    }
+    normalize_scalar(x + i, y + i, z + i, n - i);
+  }
+
+
+  __attribute__((target("avx512f")))
+  void uvs_avx512(float* u, float* v, size_t n, float scale_u, float scale_v, float offset_u, float offset_v)
+  {
+    const __m512 su = _mm512_set1_ps(scale_u), sv = _mm512_set1_ps(scale_v), ou = _mm512_set1_ps(offset_u), ov = _mm512_set1_ps(offset_v);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      _mm512_storeu_ps(u + i, _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(u + i), su), ou));
+      _mm512_storeu_ps(v + i, _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(v + i), sv), ov));
+    }
+    uvs_scalar(u + i, v + i, n - i, scale_u, scale_v, offset_u, offset_v);
+  }
+
+
+  const Kernels avx512_kernels = { transform_points_avx512, aabb_avx512, normalize_avx512, uvs_avx512 };
+#endif // SGL_SIMD_X86
+
+
+  sglSimdLevel& current_level()
+  {
+    static sglSimdLevel level = simd_supported();
+    return level;
+  }
+
+
+  const Kernels& kernels()
+  {
+#ifdef SGL_SIMD_X86
+    switch ( current_level() ) {
+    case sglSimdLevel::avx512: return avx512_kernels;
+    case sglSimdLevel::avx2: return avx2_kernels;
+    case sglSimdLevel::sse4: return sse4_kernels;
+    default: break;
+    }
+#endif
+    return scalar_kernels;
+  }
+
+} // namespace
+
+
+sglSimdLevel simd_supported()
+{
+#ifdef SGL_SIMD_X86
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports("avx512f") ) return sglSimdLevel::avx512;
+  if ( __builtin_cpu_supports("avx2") ) return sglSimdLevel::avx2;
+  if ( __builtin_cpu_supports("sse4.1") ) return sglSimdLevel::sse4;
+#endif
+  return sglSimdLevel::scalar;
+}
+
+
+sglSimdLevel simd_level()
+{
+  return current_level();
+}
+
+
+void set_simd_level(sglSimdLevel level)
+{
+  current_level() = std::min(level, simd_supported());
+}
+
+
+const char* simd_level_name(sglSimdLevel level)
+{
+  switch (level) {
+  case sglSimdLevel::avx512: return "AVX-512";
+  case sglSimdLevel::avx2: return "AVX2";
+  case sglSimdLevel::sse4: return "SSE4.1";
+  default: return "scalar";
+  }
+}
+
+
+sglSoA3 to_soa(const std::vector<glm::vec3>& vectors)
+{
+  sglSoA3 soa;
+  soa.x.resize(vectors.size());
+  soa.y.resize(vectors.size());
+  soa.z.resize(vectors.size());
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    soa.x[i] = vectors[i].x;
+    soa.y[i] = vectors[i].y;
+    soa.z[i] = vectors[i].z;
+  }
+  return soa;
+}
+
+
+sglSoA2 to_soa(const std::vector<glm::vec2>& vectors)
+{
+  sglSoA2 soa;
+  soa.x.resize(vectors.size());
+  soa.y.resize(vectors.size());
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    soa.x[i] = vectors[i].x;
+    soa.y[i] = vectors[i].y;
+  }
+  return soa;
+}
+
+
+void from_soa(const sglSoA3& soa, std::vector<glm::vec3>& vectors)
+{
+  vectors.resize(soa.size());
+  for (size_t i = 0; i < soa.size(); ++i) {
+    vectors[i] = glm::vec3(soa.x[i], soa.y[i], soa.z[i]);
+  }
+}
+
+
+void from_soa(const sglSoA2& soa, std::vector<glm::vec2>& vectors)
+{
+  vectors.resize(soa.size());
+  for (size_t i = 0; i < soa.size(); ++i) {
+    vectors[i] = glm::vec2(soa.x[i], soa.y[i]);
+  }
+}
+
+
+void transform_points(const glm::mat4& matrix, sglSoA3& points)
+{
+  float m[16];
+  for (uint32_t column = 0; column < 4; ++column) {
+    for (uint32_t row = 0; row < 4; ++row) {
+      m[4*column + row] = matrix[column][row];
+    }
+  }
+  kernels().transform_points(m, points.x.data(), points.y.data(), points.z.data(), points.size());
+}
+
+
+sglAABB compute_aabb(const sglSoA3& points)
+{
+  sglAABB box;
+  if (points.size() == 0) {
+    box.min = glm::vec3(0.0f);
+    box.max = glm::vec3(0.0f);
+    return box;
+  }
+  const float big = std::numeric_limits<float>::max();
+  float min[3] = {big, big, big}, max[3] = {-big, -big, -big};
+  kernels().aabb(points.x.data(), points.y.data(), points.z.data(), points.size(), min, max);
+  box.min = glm::vec3(min[0], min[1], min[2]);
+  box.max = glm::vec3(max[0], max[1], max[2]);
+  return box;
+}
+
+
+void normalize_vectors(sglSoA3& vectors)
+{
+  kernels().normalize(vectors.x.data(), vectors.y.data(), vectors.z.data(), vectors.size());
+}
+
+
+void transform_uvs(sglSoA2& uvs, const glm::vec2& scale, const glm::vec2& offset)
+{
+  kernels().uvs(uvs.x.data(), uvs.y.data(), uvs.size(), scale.x, scale.y, offset.x, offset.y);
+}
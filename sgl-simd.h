@@ -0,0 +1,59 @@
+/// sgl-simd.h
+/// Bulk vertex kernels on structure-of-arrays copies of loader output, with runtime instruction set dispatch
+/// author: Ulrike Hager
+
+#ifndef SGL_SIMD
+#define SGL_SIMD
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sgl-bounds.h"
+
+
+//! Ordered, each level implies the ones below. Only scalar is available on non-x86 builds.
+enum class sglSimdLevel : int { scalar = 0, sse4 = 1, avx2 = 2, avx512 = 3 };
+
+
+struct sglSoA3
+{
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  size_t size() const {return x.size();}
+};
+
+
+struct sglSoA2
+{
+  std::vector<float> x;
+  std::vector<float> y;
+  size_t size() const {return x.size();}
+};
+
+
+//! Best level supported by the CPU.
+sglSimdLevel simd_supported();
+//! Level used by the kernels, defaults to simd_supported().
+sglSimdLevel simd_level();
+//! Select a lower level, e.g. for comparisons. Levels above simd_supported() are clamped. Not thread safe.
+void set_simd_level(sglSimdLevel level);
+const char* simd_level_name(sglSimdLevel level);
+
+sglSoA3 to_soa(const std::vector<glm::vec3>& vectors);
+sglSoA2 to_soa(const std::vector<glm::vec2>& vectors);
+void from_soa(const sglSoA3& soa, std::vector<glm::vec3>& vectors);
+void from_soa(const sglSoA2& soa, std::vector<glm::vec2>& vectors);
+
+//! points = (matrix * vec4(point, 1)).xyz, no perspective divide.
+void transform_points(const glm::mat4& matrix, sglSoA3& points);
+sglAABB compute_aabb(const sglSoA3& points);
+//! Zero length vectors stay zero.
+void normalize_vectors(sglSoA3& vectors);
+//! uv = uv * scale + offset, e.g. scale (1,-1) flips v.
+void transform_uvs(sglSoA2& uvs, const glm::vec2& scale, const glm::vec2& offset);
+
+
+#endif //  SGL_SIMD
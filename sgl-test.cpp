@@ -21,6 +21,8 @@
 
 #include "sgl-helper.h"
 #include "sglWindow.h"
+#include "sglOcclusionCuller.h"
+#include "sglFramePacer.h"
 
 const int width = 1024;
 const int height = 768;
@@ -29,6 +31,7 @@ const int height = 768;
 void run()
 {
   sglWindow window("SGL Test", width, height);
+  sglFramePacer pacer(window, sglSwapMode::adaptive, 0, 2);
   glClearColor(0.08f, 0.3f, 0.04f, 1.0f);
   GLfloat camera_radius = sqrt( 12*12 + 10*10 );  // x^2+z^2
 
@@ -36,6 +39,9 @@ void run()
   std::vector<glm::vec2> uvs;
   load_blender_obj("resources/mushroom.obj", vertices, uvs, normals);
   GLuint texture = load_texture("resources/mushroom.png");
+  sglAABB mushroom_box = compute_aabb(vertices);
+  sglOccluder mushroom_occluder = make_occluder(vertices);
+  sglOcclusionCuller culler;
 
   GLfloat floor_vertices[] = {
     -6.0f, 0.0f, -6.0f,
@@ -94,7 +100,9 @@ void run()
   
   auto start_time = std::chrono::high_resolution_clock::now();
   while (!quit) {
+    pacer.wait_for_frame();
     while( SDL_PollEvent( &event ) ) {
+      pacer.input_event(event);
       if (event.type == SDL_QUIT) quit = true;
       else if (event.type == SDL_KEYDOWN ) {
 	switch ( event.key.keysym.sym ) {
@@ -115,6 +123,11 @@ void run()
     z *= camera_radius;
     glm::mat4 view_matrix = glm::lookAt( glm::vec3(x,3,z), glm::vec3(0,3,0), glm::vec3(0,1,0) );
 
+    culler.begin_frame(projection_matrix * view_matrix);
+    culler.add_occluder(mushroom_occluder, model_matrix);
+    culler.add_occluder(mushroom_occluder, model_matrix_second);
+    culler.rasterize();
+
 
     /// Draw mushrooms ///
     glUseProgram(texture_shader);
@@ -135,12 +148,16 @@ void run()
     glVertexAttribPointer ( uv_attrib, 2, GL_FLOAT, GL_FALSE, 0, 0 );
 
     /// first
-    glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model_matrix) );
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    if ( culler.is_visible(mushroom_box, model_matrix) ) {
+      glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model_matrix) );
+      glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    }
     
     /// second
-    glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model_matrix_second) );
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size()); 
+    if ( culler.is_visible(mushroom_box, model_matrix_second) ) {
+      glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model_matrix_second) );
+      glDrawArrays(GL_TRIANGLES, 0, vertices.size()); 
+    }
 
     glDisableVertexAttribArray(position_attrib);
     glDisableVertexAttribArray(uv_attrib);
@@ -195,8 +212,10 @@ void run()
 
     glDisable(GL_STENCIL_TEST);
 
-    window.swap();
+    pacer.present();
   }
+  std::cout << pacer.frame_times().summary("frame time") << "\n";
+  std::cout << pacer.input_latency().summary("input latency") << "\n";
 	
   glDeleteTextures(1, &texture);
   glDeleteBuffers(1, &vertex_buffers[0]);
@@ -0,0 +1,101 @@
+/// sgl-threads.cpp
+/// Persistent worker threads for splitting per-frame work into chunks
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sgl-threads.h"
+
+
+uint32_t thread_count(uint32_t threads, uint32_t work)
+{
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  return std::max(1u, std::min(threads, work));
+}
+
+
+sglThreadPool::sglThreadPool(uint32_t threads)
+{
+  uint32_t n_workers = thread_count(threads, UINT32_MAX) - 1;
+  for (uint32_t i = 0; i < n_workers; ++i) {
+    workers_.push_back( std::thread(&sglThreadPool::work, this, i) );
+  }
+}
+
+
+sglThreadPool::~sglThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  start_.notify_all();
+  for (auto& worker: workers_) {
+    worker.join();
+  }
+}
+
+
+void sglThreadPool::run(uint32_t count, uint32_t n_chunks, const std::function<void(uint32_t, uint32_t, uint32_t)>& func)
+{
+  n_chunks = std::max(1u, std::min(n_chunks, std::min(size(), count)));
+  if (n_chunks == 1) {
+    func(0, count, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_ = count;
+    n_chunks_ = n_chunks;
+    func_ = &func;
+    pending_ = n_chunks - 1;
+    ++generation_;
+  }
+  start_.notify_all();
+
+  func(0, (uint64_t)count / n_chunks, 0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]{ return pending_ == 0; });
+  func_ = nullptr;
+}
+
+
+void sglThreadPool::work(uint32_t worker)
+{
+  uint64_t seen = 0;
+  while (true) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    start_.wait(lock, [this, seen]{ return quit_ || generation_ != seen; });
+    if (quit_) return;
+    seen = generation_;
+    uint32_t chunk = worker + 1;
+    if (chunk >= n_chunks_) continue;
+    uint32_t count = count_, n_chunks = n_chunks_;
+    const std::function<void(uint32_t, uint32_t, uint32_t)>& func = *func_;
+    lock.unlock();
+
+    func( (uint64_t)count * chunk / n_chunks, (uint64_t)count * (chunk+1) / n_chunks, chunk );
+
+    lock.lock();
+    if (--pending_ == 0) {
+      lock.unlock();
+      done_.notify_one();
+    }
+  }
+}
+
+
+sglThreadPool& sglThreadPool::shared()
+{
+  static sglThreadPool pool;
+  return pool;
+}
@@ -0,0 +1,56 @@
+/// sgl-threads.h
+/// Persistent worker threads for splitting per-frame work into chunks
+/// author: Ulrike Hager
+
+#ifndef SGL_THREADS
+#define SGL_THREADS
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//! threads = 0 means hardware concurrency. Result is in [1, work], at least 1.
+uint32_t thread_count(uint32_t threads, uint32_t work);
+
+
+//! Workers are started once and sleep between run() calls, so per-frame work doesn't pay for thread creation.
+class sglThreadPool
+{
+ public:
+  //! Number of chunks that can run at the same time, including the calling thread. 0 uses the hardware concurrency.
+  explicit sglThreadPool(uint32_t threads = 0);
+  sglThreadPool(const sglThreadPool& toCopy) = delete;
+  sglThreadPool& operator=(const sglThreadPool& toCopy) = delete;
+  ~sglThreadPool();
+
+  uint32_t size() const {return workers_.size() + 1;}
+  //! Splits [0,count) into n_chunks contiguous chunks (capped at size() and count) and calls func(begin, end, chunk) for each.
+  //! The calling thread runs chunk 0 and returns when all chunks are done. Concurrent run() calls are serialized,
+  //! so func must not call run() on the same pool.
+  void run(uint32_t count, uint32_t n_chunks, const std::function<void(uint32_t, uint32_t, uint32_t)>& func);
+
+  //! Process wide pool shared by the occlusion culler and the meshlet functions, so they don't compete with separate workers.
+  static sglThreadPool& shared();
+
+ private:
+  void work(uint32_t worker);
+
+  std::vector<std::thread> workers_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  uint64_t generation_ = 0;
+  uint32_t pending_ = 0;
+  bool quit_ = false;
+  uint32_t count_ = 0;
+  uint32_t n_chunks_ = 0;
+  const std::function<void(uint32_t, uint32_t, uint32_t)>* func_ = nullptr;
+};
+
+
+#endif //  SGL_THREADS
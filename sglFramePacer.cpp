@@ -0,0 +1,217 @@
+/// sglFramePacer.cpp
+/// Frame pacing: swap interval, frame limiter, frames-in-flight cap and latency histograms
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <SDL2/SDL.h>
+
+#include "sglFramePacer.h"
+#include "sglWindow.h"
+
+
+namespace {
+
+  bool is_input_event(uint32_t type)
+  {
+    switch (type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_TEXTINPUT:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+    case SDL_JOYAXISMOTION:
+    case SDL_JOYBUTTONDOWN:
+    case SDL_JOYBUTTONUP:
+    case SDL_JOYHATMOTION:
+    case SDL_CONTROLLERAXISMOTION:
+    case SDL_CONTROLLERBUTTONDOWN:
+    case SDL_CONTROLLERBUTTONUP:
+    case SDL_FINGERDOWN:
+    case SDL_FINGERUP:
+    case SDL_FINGERMOTION:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+} // namespace
+
+
+sglHistogram::sglHistogram(float bin_width, uint32_t n_bins)
+  : bin_width_(bin_width), bins_(n_bins, 0)
+{
+  if ( bin_width <= 0 || n_bins == 0 )
+    throw std::runtime_error("[sglHistogram] Need bin_width > 0 and at least one bin");
+}
+
+
+void sglHistogram::add(float value)
+{
+  value = std::max(0.0f, value);
+  uint32_t bin = (uint32_t)(value / bin_width_);
+  if (bin < bins_.size())
+    ++bins_[bin];
+  else
+    ++overflow_;
+  ++count_;
+  sum_ += value;
+  max_ = std::max(max_, value);
+}
+
+
+void sglHistogram::clear()
+{
+  std::fill(bins_.begin(), bins_.end(), 0);
+  overflow_ = 0;
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+
+float sglHistogram::percentile(float fraction) const
+{
+  if (count_ == 0) return 0;
+  uint32_t target = (uint32_t)std::ceil( std::min(1.0f, std::max(0.0f, fraction)) * count_ );
+  target = std::max(1u, target);
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < bins_.size(); ++i) {
+    sum += bins_[i];
+    if (sum >= target)
+      return std::min(max_, (i + 1) * bin_width_);
+  }
+  return max_;
+}
+
+
+std::string sglHistogram::summary(const std::string& name, const std::string& unit) const
+{
+  std::stringstream strstr;
+  strstr << name << ": " << count_ << " entries, mean " << mean() << " " << unit
+	 << ", median " << percentile(0.5f) << ", 99% " << percentile(0.99f) << ", max " << max_ << " " << unit;
+  if (overflow_)
+    strstr << " (" << overflow_ << " above " << bins_.size() * bin_width_ << " " << unit << ")";
+  return strstr.str();
+}
+
+
+sglFramePacer::sglFramePacer(sglWindow& window, sglSwapMode mode, float target_fps, uint32_t max_frames_in_flight)
+  : window_(window), frame_times_(0.25f, 400), input_latency_(0.5f, 400)
+{
+  set_swap_mode(mode);
+  set_target_fps(target_fps);
+  set_max_frames_in_flight(max_frames_in_flight);
+  next_frame_ = Clock::now();
+}
+
+
+sglFramePacer::~sglFramePacer()
+{
+  for (auto fence: fences_) {
+    glDeleteSync(fence);
+  }
+}
+
+
+bool sglFramePacer::set_swap_mode(sglSwapMode mode)
+{
+  mode_ = static_cast<sglSwapMode>( window_.set_swap_interval( static_cast<int>(mode) ) );
+  return mode_ == mode;
+}
+
+
+void sglFramePacer::set_target_fps(float fps)
+{
+  if (fps > 0)
+    frame_period_ = std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>(1.0 / fps) );
+  else
+    frame_period_ = Clock::duration::zero();
+}
+
+
+void sglFramePacer::set_max_frames_in_flight(uint32_t frames)
+{
+  max_frames_in_flight_ = frames;
+  if (frames > 0)
+    wait_for_fences(frames);
+}
+
+
+void sglFramePacer::wait_for_frame()
+{
+  if ( frame_period_ == Clock::duration::zero() ) return;
+
+  auto spin = std::chrono::duration_cast<Clock::duration>(spin_time_);
+  auto now = Clock::now();
+  if (next_frame_ - now > spin) {
+    std::this_thread::sleep_for(next_frame_ - now - spin);
+  }
+  while ( (now = Clock::now()) < next_frame_ ) {
+    // spin for the last part, sleep_for may overshoot by a scheduler tick
+  }
+  // keep the cadence when on time or slightly late; if the next deadline has already passed as well,
+  // restart from now instead of rendering the missed frames back to back
+  if (next_frame_ + frame_period_ < now)
+    next_frame_ = now + frame_period_;
+  else
+    next_frame_ += frame_period_;
+}
+
+
+void sglFramePacer::input_event(const SDL_Event& event)
+{
+  if ( have_input_ || !is_input_event(event.type) ) return;
+  // The event may have been waiting in the queue, go back to when SDL received it (millisecond resolution).
+  uint32_t queued_ms = SDL_GetTicks() - event.common.timestamp;
+  first_input_ = Clock::now() - std::chrono::duration_cast<Clock::duration>( std::chrono::milliseconds(queued_ms) );
+  have_input_ = true;
+}
+
+
+void sglFramePacer::present()
+{
+  window_.swap();
+  if (max_frames_in_flight_ > 0) {
+    fences_.push_back( glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) );
+    wait_for_fences(max_frames_in_flight_);
+  }
+
+  auto now = Clock::now();
+  if (have_present_) {
+    frame_times_.add( std::chrono::duration<float, std::milli>(now - last_present_).count() );
+  }
+  if (have_input_) {
+    input_latency_.add( std::chrono::duration<float, std::milli>(now - first_input_).count() );
+    have_input_ = false;
+  }
+  last_present_ = now;
+  have_present_ = true;
+}
+
+
+void sglFramePacer::wait_for_fences(uint32_t max_pending)
+{
+  const GLuint64 timeout_ns = 100000000;  // 100 ms, loop again if the GPU is that far behind
+  while (fences_.size() > max_pending) {
+    GLenum result = glClientWaitSync(fences_.front(), GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+    if (result == GL_TIMEOUT_EXPIRED) continue;
+    if (result == GL_WAIT_FAILED)
+      std::cerr << "[sglFramePacer] glClientWaitSync failed" << std::endl;
+    glDeleteSync(fences_.front());
+    fences_.pop_front();
+  }
+}
@@ -0,0 +1,107 @@
+/// sglFramePacer.h
+/// Frame pacing: swap interval, frame limiter, frames-in-flight cap and latency histograms
+/// author: Ulrike Hager
+
+#ifndef SGL_FRAME_PACER
+#define SGL_FRAME_PACER
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <SDL2/SDL.h>
+
+#include "sglWindow.h"
+
+
+//! Values are the SDL_GL_SetSwapInterval arguments.
+enum class sglSwapMode : int { adaptive = -1, immediate = 0, vsync = 1 };
+
+
+//! Fixed width bins starting at 0, values beyond the last bin are counted as overflow.
+class sglHistogram
+{
+ public:
+  sglHistogram(float bin_width, uint32_t n_bins);
+
+  void add(float value);
+  void clear();
+  uint32_t count() const {return count_;}
+  uint32_t overflow() const {return overflow_;}
+  float mean() const {return count_ ? float(sum_ / count_) : 0;}
+  float max() const {return max_;}
+  //! Upper edge of the bin containing the given fraction (0-1) of all entries; max() if it falls into the overflow.
+  float percentile(float fraction) const;
+  const std::vector<uint32_t>& bins() const {return bins_;}
+  float bin_width() const {return bin_width_;}
+  //! One line: count, mean, median, 99th percentile, max.
+  std::string summary(const std::string& name, const std::string& unit = "ms") const;
+
+ private:
+  float bin_width_;
+  std::vector<uint32_t> bins_;
+  uint32_t overflow_ = 0;
+  uint32_t count_ = 0;
+  //! double: a float sum drops the low bits of each frame time after a few hours at 60 Hz and the mean drifts.
+  double sum_ = 0;
+  float max_ = 0;
+};
+
+
+//! Usage per frame: wait_for_frame(), poll events and pass them to input_event(), render, present().
+//! Input latency is measured from the SDL event timestamp of the first input event after the previous present
+//! until the swap returned (and, with a frames-in-flight cap, the GPU finished enough of the queue).
+class sglFramePacer
+{
+ public:
+  //! target_fps = 0 disables the limiter, max_frames_in_flight = 0 disables the fence waits.
+  sglFramePacer(sglWindow& window, sglSwapMode mode = sglSwapMode::vsync, float target_fps = 0, uint32_t max_frames_in_flight = 0);
+  sglFramePacer(const sglFramePacer& toCopy) = delete;
+  sglFramePacer& operator=(const sglFramePacer& toCopy) = delete;
+  ~sglFramePacer();
+
+  //! Uses the interval sglWindow::set_swap_interval() applied, e.g. vsync if adaptive isn't supported; returns false if it differs from mode.
+  bool set_swap_mode(sglSwapMode mode);
+  sglSwapMode swap_mode() const {return mode_;}
+  void set_target_fps(float fps);
+  void set_max_frames_in_flight(uint32_t frames);
+  //! Time before the frame deadline that is busy-waited instead of slept, covers the OS sleep granularity.
+  void set_spin_time(float milliseconds) {spin_time_ = std::chrono::duration<float, std::milli>(milliseconds);}
+
+  //! Sleeps until the next frame is due. Call before polling events so input is sampled as late as possible.
+  void wait_for_frame();
+  void input_event(const SDL_Event& event);
+  //! Swaps the window, waits for old fences if too many frames are queued and records frame time and latency.
+  void present();
+
+  const sglHistogram& frame_times() const {return frame_times_;}
+  const sglHistogram& input_latency() const {return input_latency_;}
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  void wait_for_fences(uint32_t max_pending);
+
+  sglWindow& window_;
+  sglSwapMode mode_ = sglSwapMode::vsync;
+  Clock::duration frame_period_ = Clock::duration::zero();
+  std::chrono::duration<float, std::milli> spin_time_ = std::chrono::duration<float, std::milli>(1.5f);
+  uint32_t max_frames_in_flight_ = 0;
+  std::deque<GLsync> fences_;
+
+  Clock::time_point next_frame_;
+  Clock::time_point last_present_;
+  bool have_present_ = false;
+  Clock::time_point first_input_;
+  bool have_input_ = false;
+
+  sglHistogram frame_times_;
+  sglHistogram input_latency_;
+};
+
+
+#endif //  SGL_FRAME_PACER
@@ -0,0 +1,409 @@
+/// sglOcclusionCuller.cpp
+/// CPU occlusion culling: software rasterized depth buffer + hierarchical depth (Hi-Z) tests
+/// author: Ulrike Hager
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && ( defined(__GNUC__) || defined(__clang__) )
+#define SGL_OCCLUSION_X86
+#include <immintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "sgl-threads.h"
+#include "sglOcclusionCuller.h"
+
+
+namespace {
+
+  struct CompareVec3
+  {
+    bool operator()(const glm::vec3& lhs, const glm::vec3& rhs) const {
+      if (lhs.x != rhs.x) return lhs.x < rhs.x;
+      if (lhs.y != rhs.y) return lhs.y < rhs.y;
+      return lhs.z < rhs.z;
+    }
+  };
+
+  //! Clip space -> [0,width] x [0,height] x [0,1]
+  inline void to_screen(const glm::vec4& clip, float width, float height, float& x, float& y, float& z)
+  {
+    float inv_w = 1.0f / clip.w;
+    x = (clip.x * inv_w * 0.5f + 0.5f) * width;
+    y = (clip.y * inv_w * 0.5f + 0.5f) * height;
+    z = clip.z * inv_w * 0.5f + 0.5f;
+  }
+
+  typedef void (*RowKernel)(float* row, uint32_t x_begin, uint32_t x_end, float y_centre, const float* edge_a, const float* edge_b, const float* edge_c, float z_a, float z_b, float z_c);
+
+  //! Writes min(depth, plane) into row[x] for all x in [x_begin, x_end) whose pixel centre is inside the triangle.
+  //! Edge and depth functions are e = a*x + b*y + c, evaluated at pixel centres.
+  //! x_begin is a multiple of 8 and the buffer width is rounded up to a multiple of 8, so the vector loops may run past x_end but stay inside the row.
+  void rasterize_row_scalar(float* row, uint32_t x_begin, uint32_t x_end, float y_centre, const float* edge_a, const float* edge_b, const float* edge_c, float z_a, float z_b, float z_c)
+  {
+    float e0_row = edge_b[0] * y_centre + edge_c[0];
+    float e1_row = edge_b[1] * y_centre + edge_c[1];
+    float e2_row = edge_b[2] * y_centre + edge_c[2];
+    float z_row = z_b * y_centre + z_c;
+    for (uint32_t x = x_begin; x < x_end; ++x) {
+      float xs = x + 0.5f;
+      if ( edge_a[0]*xs + e0_row < 0 || edge_a[1]*xs + e1_row < 0 || edge_a[2]*xs + e2_row < 0 )
+	continue;
+      float z = z_a * xs + z_row;
+      if (z < row[x]) row[x] = z;
+    }
+  }
+
+
+#ifdef SGL_OCCLUSION_X86
+  __attribute__((target("sse2")))
+  void rasterize_row_sse2(float* row, uint32_t x_begin, uint32_t x_end, float y_centre, const float* edge_a, const float* edge_b, const float* edge_c, float z_a, float z_b, float z_c)
+  {
+    float e0_row = edge_b[0] * y_centre + edge_c[0];
+    float e1_row = edge_b[1] * y_centre + edge_c[1];
+    float e2_row = edge_b[2] * y_centre + edge_c[2];
+    float z_row = z_b * y_centre + z_c;
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    for (uint32_t x = x_begin; x < x_end; x += 4) {
+      __m128 xs = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+      __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[0]), xs), _mm_set1_ps(e0_row));
+      __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[1]), xs), _mm_set1_ps(e1_row));
+      __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[2]), xs), _mm_set1_ps(e2_row));
+      __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+      if (_mm_movemask_ps(inside) == 0) continue;
+      __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(z_a), xs), _mm_set1_ps(z_row));
+      __m128 old_z = _mm_loadu_ps(row + x);
+      __m128 min_z = _mm_min_ps(old_z, z);
+      __m128 new_z = _mm_or_ps(_mm_and_ps(inside, min_z), _mm_andnot_ps(inside, old_z));
+      _mm_storeu_ps(row + x, new_z);
+    }
+  }
+
+
+  __attribute__((target("avx2")))
+  void rasterize_row_avx2(float* row, uint32_t x_begin, uint32_t x_end, float y_centre, const float* edge_a, const float* edge_b, const float* edge_c, float z_a, float z_b, float z_c)
+  {
+    float e0_row = edge_b[0] * y_centre + edge_c[0];
+    float e1_row = edge_b[1] * y_centre + edge_c[1];
+    float e2_row = edge_b[2] * y_centre + edge_c[2];
+    float z_row = z_b * y_centre + z_c;
+    const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    for (uint32_t x = x_begin; x < x_end; x += 8) {
+      __m256 xs = _mm256_add_ps(_mm256_set1_ps((float)x), offsets);
+      __m256 e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge_a[0]), xs), _mm256_set1_ps(e0_row));
+      __m256 e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge_a[1]), xs), _mm256_set1_ps(e1_row));
+      __m256 e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge_a[2]), xs), _mm256_set1_ps(e2_row));
+      __m256 inside = _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+				    _mm256_and_ps(_mm256_cmp_ps(e1, zero, _CMP_GE_OQ), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ)));
+      if (_mm256_movemask_ps(inside) == 0) continue;
+      __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(z_a), xs), _mm256_set1_ps(z_row));
+      __m256 old_z = _mm256_loadu_ps(row + x);
+      __m256 new_z = _mm256_blendv_ps(old_z, _mm256_min_ps(old_z, z), inside);
+      _mm256_storeu_ps(row + x, new_z);
+    }
+  }
+#endif // SGL_OCCLUSION_X86
+
+
+  //! Picked once from the CPU features, like the sgl-simd kernels.
+  RowKernel row_kernel()
+  {
+#ifdef SGL_OCCLUSION_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") ) return rasterize_row_avx2;
+    if ( __builtin_cpu_supports("sse2") ) return rasterize_row_sse2;
+#endif
+    return rasterize_row_scalar;
+  }
+
+} // namespace
+
+
+sglOccluder make_occluder(const std::vector<glm::vec3>& vertices, uint32_t max_triangles)
+{
+  sglOccluder occluder;
+  std::map<glm::vec3, uint32_t, CompareVec3> welded;
+  std::vector<uint32_t> indices;
+  indices.reserve(vertices.size());
+  for (const auto& vertex: vertices) {
+    auto found = welded.find(vertex);
+    if (found == welded.end()) {
+      found = welded.insert(std::make_pair(vertex, (uint32_t)occluder.vertices.size())).first;
+      occluder.vertices.push_back(vertex);
+    }
+    indices.push_back(found->second);
+  }
+
+  std::vector<std::pair<float, uint32_t> > areas;
+  for (uint32_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t a = indices[i], b = indices[i+1], c = indices[i+2];
+    if (a == b || b == c || a == c) continue;
+    const glm::vec3& va = occluder.vertices[a];
+    float area = glm::length(glm::cross(occluder.vertices[b] - va, occluder.vertices[c] - va));
+    if (area > 0.0f)
+      areas.push_back(std::make_pair(area, i));
+  }
+  if (areas.size() > max_triangles) {
+    std::nth_element(areas.begin(), areas.begin() + max_triangles, areas.end(),
+		     [](const std::pair<float, uint32_t>& lhs, const std::pair<float, uint32_t>& rhs){ return lhs.first > rhs.first; });
+    areas.resize(max_triangles);
+  }
+  // keep the original triangle order, it is usually spatially coherent
+  std::sort(areas.begin(), areas.end(),
+	    [](const std::pair<float, uint32_t>& lhs, const std::pair<float, uint32_t>& rhs){ return lhs.second < rhs.second; });
+
+  occluder.indices.reserve(areas.size() * 3);
+  for (const auto& area: areas) {
+    occluder.indices.push_back(indices[area.second]);
+    occluder.indices.push_back(indices[area.second + 1]);
+    occluder.indices.push_back(indices[area.second + 2]);
+  }
+  return occluder;
+}
+
+
+sglOcclusionCuller::sglOcclusionCuller(uint32_t width, uint32_t height, uint32_t threads)
+  : width_( (width + 7) & ~7u ), height_(height), view_projection_(1.0f)
+{
+  if (width == 0 || height == 0)
+    throw std::runtime_error("[sglOcclusionCuller] Depth buffer size must not be 0");
+  tiles_ = std::min( thread_count(threads, std::max(1u, height_ / min_tile_rows)), sglThreadPool::shared().size() );
+
+  uint32_t w = width_, h = height_;
+  while (true) {
+    level_width_.push_back(w);
+    level_height_.push_back(h);
+    hiz_.push_back(std::vector<float>(w * h, 1.0f));
+    if (w == 1 && h == 1) break;
+    w = std::max(1u, (w + 1) / 2);
+    h = std::max(1u, (h + 1) / 2);
+  }
+}
+
+
+void sglOcclusionCuller::begin_frame(const glm::mat4& view_projection)
+{
+  view_projection_ = view_projection;
+  triangles_.clear();
+  for (auto& level: hiz_) {
+    std::fill(level.begin(), level.end(), 1.0f);
+  }
+}
+
+
+void sglOcclusionCuller::add_occluder(const sglOccluder& occluder, const glm::mat4& model)
+{
+  glm::mat4 mvp = view_projection_ * model;
+  std::vector<glm::vec4> clip;
+  clip.reserve(occluder.vertices.size());
+  for (const auto& vertex: occluder.vertices) {
+    clip.push_back( mvp * glm::vec4(vertex, 1.0f) );
+  }
+
+  for (uint32_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+    const glm::vec4& a = clip.at( occluder.indices[i] );
+    const glm::vec4& b = clip.at( occluder.indices[i+1] );
+    const glm::vec4& c = clip.at( occluder.indices[i+2] );
+    // trivially outside one of the side or far planes
+    if ( (a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w)
+	 || (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w)
+	 || (a.z > a.w && b.z > b.w && c.z > c.w) )
+      continue;
+
+    // clip against the near plane z = -w
+    glm::vec4 in[3] = {a, b, c};
+    glm::vec4 out[4];
+    uint32_t n_out = 0;
+    for (uint32_t j = 0; j < 3; ++j) {
+      const glm::vec4& current = in[j];
+      const glm::vec4& next = in[(j+1) % 3];
+      float d_current = current.z + current.w;
+      float d_next = next.z + next.w;
+      if (d_current >= 0)
+	out[n_out++] = current;
+      if ( (d_current >= 0) != (d_next >= 0) ) {
+	float t = d_current / (d_current - d_next);
+	out[n_out++] = current + (next - current) * t;
+      }
+    }
+    for (uint32_t j = 1; j + 1 < n_out; ++j) {
+      add_clipped_triangle(out[0], out[j], out[j+1]);
+    }
+  }
+}
+
+
+void sglOcclusionCuller::add_clipped_triangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+  const float min_w = 1e-6f;
+  if (a.w < min_w || b.w < min_w || c.w < min_w) return;
+
+  ScreenTriangle tri;
+  to_screen(a, width_, height_, tri.x[0], tri.y[0], tri.z[0]);
+  to_screen(b, width_, height_, tri.x[1], tri.y[1], tri.z[1]);
+  to_screen(c, width_, height_, tri.x[2], tri.y[2], tri.z[2]);
+  triangles_.push_back(tri);
+}
+
+
+void sglOcclusionCuller::rasterize()
+{
+  sglThreadPool::shared().run(height_, tiles_, [this](uint32_t row_begin, uint32_t row_end, uint32_t) {
+      rasterize_tile(row_begin, row_end);
+    });
+  build_hiz();
+}
+
+
+void sglOcclusionCuller::rasterize_tile(uint32_t row_begin, uint32_t row_end)
+{
+  for (const auto& tri: triangles_) {
+    rasterize_triangle(tri, row_begin, row_end);
+  }
+}
+
+
+void sglOcclusionCuller::rasterize_triangle(const ScreenTriangle& tri, uint32_t row_begin, uint32_t row_end)
+{
+  float min_x = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+  float max_x = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+  float min_y = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+  float max_y = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+  if (max_x < 0 || max_y < row_begin || min_x >= width_ || min_y >= row_end) return;
+
+  // pixel (x,y) has its centre at (x+0.5, y+0.5)
+  uint32_t x_begin = (uint32_t) std::max(0.0f, std::floor(min_x));
+  uint32_t x_end = (uint32_t) std::min((float)width_, std::ceil(max_x) + 1);
+  uint32_t y_begin = std::max(row_begin, (uint32_t) std::max(0.0f, std::floor(min_y)));
+  uint32_t y_end = std::min(row_end, (uint32_t) std::min((float)height_, std::ceil(max_y) + 1));
+  x_begin &= ~7u;
+
+  // edge i is opposite vertex i: e_i(x,y) = a*x + b*y + c, positive inside for counter clockwise triangles
+  float edge_a[3], edge_b[3], edge_c[3];
+  for (uint32_t i = 0; i < 3; ++i) {
+    uint32_t j = (i+1) % 3, k = (i+2) % 3;
+    edge_a[i] = tri.y[j] - tri.y[k];
+    edge_b[i] = tri.x[k] - tri.x[j];
+    edge_c[i] = tri.x[j] * tri.y[k] - tri.x[k] * tri.y[j];
+  }
+  float area = edge_c[0] + edge_c[1] + edge_c[2];
+  if (std::fabs(area) < 1e-8f) return;
+  if (area < 0) {
+    // occluders are rasterized double sided
+    for (uint32_t i = 0; i < 3; ++i) {
+      edge_a[i] = -edge_a[i];
+      edge_b[i] = -edge_b[i];
+      edge_c[i] = -edge_c[i];
+    }
+    area = -area;
+  }
+
+  // z(x,y) = sum_i e_i(x,y) z_i / area
+  float z_a = 0, z_b = 0, z_c = 0;
+  for (uint32_t i = 0; i < 3; ++i) {
+    z_a += edge_a[i] * tri.z[i];
+    z_b += edge_b[i] * tri.z[i];
+    z_c += edge_c[i] * tri.z[i];
+  }
+  z_a /= area;
+  z_b /= area;
+  z_c /= area;
+
+  static const RowKernel rasterize_row = row_kernel();
+  std::vector<float>& buffer = hiz_[0];
+  for (uint32_t y = y_begin; y < y_end; ++y) {
+    rasterize_row(&buffer[y * width_], x_begin, x_end, y + 0.5f, edge_a, edge_b, edge_c, z_a, z_b, z_c);
+  }
+}
+
+
+void sglOcclusionCuller::build_hiz()
+{
+  for (uint32_t level = 1; level < hiz_.size(); ++level) {
+    const std::vector<float>& below = hiz_[level-1];
+    std::vector<float>& current = hiz_[level];
+    uint32_t below_width = level_width_[level-1], below_height = level_height_[level-1];
+    for (uint32_t y = 0; y < level_height_[level]; ++y) {
+      uint32_t y0 = std::min(2*y, below_height-1), y1 = std::min(2*y+1, below_height-1);
+      for (uint32_t x = 0; x < level_width_[level]; ++x) {
+	uint32_t x0 = std::min(2*x, below_width-1), x1 = std::min(2*x+1, below_width-1);
+	float farthest = std::max( std::max(below[y0*below_width + x0], below[y0*below_width + x1]),
+			      std::max(below[y1*below_width + x0], below[y1*below_width + x1]) );
+	current[y*level_width_[level] + x] = farthest;
+      }
+    }
+  }
+}
+
+
+bool sglOcclusionCuller::is_visible(const sglAABB& box, const glm::mat4& model) const
+{
+  glm::mat4 mvp = view_projection_ * model;
+  const float big = std::numeric_limits<float>::max();
+  float min_x = big, max_x = -big, min_y = big, max_y = -big, min_z = big;
+  for (uint32_t i = 0; i < 8; ++i) {
+    glm::vec4 corner( (i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z, 1.0f);
+    glm::vec4 clip = mvp * corner;
+    // box crosses the near plane, can't be tested reliably
+    if (clip.z < -clip.w || clip.w <= 0) return true;
+    float inv_w = 1.0f / clip.w;
+    float x = clip.x * inv_w, y = clip.y * inv_w, z = clip.z * inv_w;
+    min_x = std::min(min_x, x);
+    max_x = std::max(max_x, x);
+    min_y = std::min(min_y, y);
+    max_y = std::max(max_y, y);
+    min_z = std::min(min_z, z);
+  }
+  if (max_x < -1 || min_x > 1 || max_y < -1 || min_y > 1 || min_z > 1) return false;
+
+  float nearest = min_z * 0.5f + 0.5f;
+  int32_t x0 = (int32_t) std::floor( (min_x * 0.5f + 0.5f) * width_ );
+  int32_t x1 = (int32_t) std::floor( (max_x * 0.5f + 0.5f) * width_ );
+  int32_t y0 = (int32_t) std::floor( (min_y * 0.5f + 0.5f) * height_ );
+  int32_t y1 = (int32_t) std::floor( (max_y * 0.5f + 0.5f) * height_ );
+  x0 = std::max(0, std::min(x0, (int32_t)width_ - 1));
+  x1 = std::max(0, std::min(x1, (int32_t)width_ - 1));
+  y0 = std::max(0, std::min(y0, (int32_t)height_ - 1));
+  y1 = std::max(0, std::min(y1, (int32_t)height_ - 1));
+
+  // coarsest level needed so that the rectangle covers at most 2x2 texels
+  uint32_t level = 0;
+  while ( level + 1 < hiz_.size() && ( (x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1 ) ) {
+    ++level;
+  }
+  uint32_t lx0 = x0 >> level, lx1 = x1 >> level;
+  uint32_t ly0 = y0 >> level, ly1 = y1 >> level;
+  const std::vector<float>& texels = hiz_[level];
+  uint32_t level_width = level_width_[level];
+  float farthest = 0;
+  for (uint32_t y = ly0; y <= ly1; ++y) {
+    for (uint32_t x = lx0; x <= lx1; ++x) {
+      farthest = std::max(farthest, texels[y*level_width + x]);
+    }
+  }
+  return nearest <= farthest;
+}
+
+
+void sglOcclusionCuller::test(const std::vector<sglAABB>& boxes, std::vector<uint8_t>& visible) const
+{
+  const glm::mat4 identity(1.0f);
+  visible.resize(boxes.size());
+  for (uint32_t i = 0; i < boxes.size(); ++i) {
+    visible[i] = is_visible(boxes[i], identity) ? 1 : 0;
+  }
+}
+
+
+float sglOcclusionCuller::depth(uint32_t x, uint32_t y, uint32_t level) const
+{
+  return hiz_.at(level).at( y * level_width_.at(level) + x );
+}
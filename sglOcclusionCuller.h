@@ -0,0 +1,88 @@
+/// sglOcclusionCuller.h
+/// CPU occlusion culling: software rasterized depth buffer + hierarchical depth (Hi-Z) tests
+/// author: Ulrike Hager
+
+#ifndef SGL_OCCLUSION_CULLER
+#define SGL_OCCLUSION_CULLER
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sgl-bounds.h"
+#include "sgl-threads.h"
+
+
+//! Indexed triangle mesh used only for rasterizing into the occlusion buffer.
+struct sglOccluder
+{
+  std::vector<glm::vec3> vertices;
+  std::vector<uint32_t> indices;
+};
+
+
+//! Build an occluder from triangle soup as returned by load_blender_obj.
+//! Duplicate positions are welded, degenerate triangles dropped and only the max_triangles largest triangles are kept.
+//! The result is a subset of the original surface, so it never occludes more than the mesh itself.
+sglOccluder make_occluder(const std::vector<glm::vec3>& vertices, uint32_t max_triangles = 256);
+
+
+//! Usage per frame: begin_frame(), add_occluder() for each occluder instance, rasterize(), then is_visible() for each instance.
+//! Does not use OpenGL, only the matrices are shared with the renderer.
+class sglOcclusionCuller
+{
+ public:
+  //! width is rounded up to a multiple of 8. Tiles run on sglThreadPool::shared(), threads = 0 uses all of its threads.
+  //! Tiles are at least min_tile_rows high, so small buffers use fewer threads.
+  sglOcclusionCuller(uint32_t width = 256, uint32_t height = 128, uint32_t threads = 0);
+  sglOcclusionCuller(const sglOcclusionCuller& toCopy) = delete;
+  sglOcclusionCuller& operator=(const sglOcclusionCuller& toCopy) = delete;
+
+  //! Clears depth buffer and occluder list.
+  void begin_frame(const glm::mat4& view_projection);
+  //! Transforms and near-clips the occluder triangles, rasterization happens in rasterize().
+  void add_occluder(const sglOccluder& occluder, const glm::mat4& model);
+  //! Rasterizes all occluders, split into horizontal tiles across the worker threads, then builds the Hi-Z pyramid.
+  void rasterize();
+
+  //! False if the box is completely behind the rasterized occluders or outside the view.
+  bool is_visible(const sglAABB& box, const glm::mat4& model) const;
+  //! World space boxes. visible[i] is set to 1 or 0.
+  void test(const std::vector<sglAABB>& boxes, std::vector<uint8_t>& visible) const;
+
+  //! Depth in [0,1] of texel (x,y) of Hi-Z level; level 0 is the full resolution depth buffer.
+  float depth(uint32_t x, uint32_t y, uint32_t level = 0) const;
+  uint32_t levels() const {return hiz_.size();}
+  uint32_t width(uint32_t level = 0) const {return level_width_.at(level);}
+  uint32_t height(uint32_t level = 0) const {return level_height_.at(level);}
+  uint32_t triangles() const {return triangles_.size();}
+
+ private:
+  struct ScreenTriangle
+  {
+    float x[3];
+    float y[3];
+    float z[3];
+  };
+
+  void add_clipped_triangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+  void rasterize_tile(uint32_t row_begin, uint32_t row_end);
+  void rasterize_triangle(const ScreenTriangle& tri, uint32_t row_begin, uint32_t row_end);
+  void build_hiz();
+
+  static const uint32_t min_tile_rows = 16;
+
+  uint32_t width_ = 256;
+  uint32_t height_ = 128;
+  uint32_t tiles_ = 1;
+  glm::mat4 view_projection_;
+  std::vector<ScreenTriangle> triangles_;
+  //! hiz_[0] is the depth buffer. Each level stores the farthest depth of the 2x2 texels below it.
+  std::vector< std::vector<float> > hiz_;
+  std::vector<uint32_t> level_width_;
+  std::vector<uint32_t> level_height_;
+};
+
+
+#endif //  SGL_OCCLUSION_CULLER
@@ -18,7 +18,7 @@
 #include "sglWindow.h"
 
 
-sglWindow::sglWindow(std::string name, int width, int height)
+sglWindow::sglWindow(std::string name, int width, int height, int swap_interval)
   : width_(width), height_(height)
 {
   
@@ -50,7 +50,7 @@ sglWindow::sglWindow(std::string name, int width, int height)
     throw std::runtime_error( strstr.str()  ) ;
   }
 
-  SDL_GL_SetSwapInterval(1);
+  set_swap_interval(swap_interval);
   glClearColor(0.08f, 0.0f, 0.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT);
   swap();
@@ -60,3 +60,17 @@ sglWindow::sglWindow(std::string name, int width, int height)
 }
 
 
+int sglWindow::set_swap_interval(int interval)
+{
+  if ( SDL_GL_SetSwapInterval(interval) == 0 )
+    return interval;
+  if ( interval == -1 ) {
+    std::cerr << "Adaptive vsync not supported, using vsync: " << SDL_GetError() << std::endl;
+    if ( SDL_GL_SetSwapInterval(1) == 0 )
+      return 1;
+  }
+  else {
+    std::cerr << "Swap interval " << interval << " not supported: " << SDL_GetError() << std::endl;
+  }
+  return SDL_GL_GetSwapInterval();
+}
@@ -34,13 +34,18 @@ struct DeleteContext
 class sglWindow
 {
  public:
-  sglWindow(std::string name, int width, int height);
+  //! swap_interval: 0 immediate, 1 vsync, -1 adaptive vsync
+  sglWindow(std::string name, int width, int height, int swap_interval = 1);
   sglWindow(const sglWindow& toCopy) = delete;
   sglWindow& operator=(const sglWindow& toCopy) = delete;
   void swap() {
     if (window_)
       SDL_GL_SwapWindow(window_.get());
   } 
+  //! Returns the interval actually applied. -1 (adaptive) falls back to 1 if the driver doesn't support it,
+  //! other unsupported intervals leave the current one.
+  int set_swap_interval(int interval);
+  int swap_interval() {return SDL_GL_GetSwapInterval();}
 
   uint32_t width() {return width_;}
   uint32_t height() {return height_;}